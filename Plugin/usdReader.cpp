@@ -26,6 +26,7 @@
 
 #include "usdReader.h"
 
+#include <algorithm>
 #include <fstream>
 #include <DDImage/Application.h>
 #include <DDImage/File_KnobI.h>
@@ -73,15 +74,43 @@ SceneGraph_KnobI* usdReader::getSceneGraphKnob()
 
 void usdReader::get_geometry_hash(Hash* geo_hash)
 {
-  // Rebuild primitives on change of filename, current frame (conditionally) etc.
-  append(geo_hash[Group_Primitives]);
+  // Rebuild primitives on change of filename, selection or options
+  appendOptions(geo_hash[Group_Primitives]);
   // The geometry hashes need to be calculated correctly when things change.
   const auto pfmt = getFormat();
   if (pfmt->_readOnEachFrame) {
-    geo_hash[Group_Matrix].append(geo->outputContext().frame());
+    const auto frame = geo->outputContext().frame();
+    // Only the parts of the geometry that animate in the file change with the frame
+    const auto animation = getAnimation();
+    // Prims and instances can move in and out of the crop box
+    if(animation.topology || pfmt->_crop) {
+      geo_hash[Group_Primitives].append(frame);
+    }
+    // Merged meshes have their transforms baked into the points, and so do
+    // the proxies of instancers over the instance threshold
+    if(animation.topology || animation.points || pfmt->_mergeFaceCount > 0 ||
+       (animation.instances && pfmt->_instanceThreshold > 0)) {
+      geo_hash[Group_Points].append(frame);
+    }
+    geo_hash[Group_Matrix].append(frame);
+    geo_hash[Group_Attributes].append(frame);
   }
 }
 
+Foundry::UsdConverter::StageAnimation usdReader::getAnimation()
+{
+  const auto pSceneGraphKnob = getSceneGraphKnob();
+  const char* fileName = filename();
+  if(!pSceneGraphKnob || !fileName || !_fileExists) {
+    Foundry::UsdConverter::StageAnimation everything;
+    everything.topology = true;
+    everything.points = true;
+    everything.instances = true;
+    return everything;
+  }
+  return _cache.animation(fileName, pSceneGraphKnob->getSelectedItems());
+}
+
 void usdReader::geometry_engine(Scene&, GeometryList& out)
 {
   const auto pSceneGraphKnob = getSceneGraphKnob();
@@ -99,11 +128,31 @@ void usdReader::geometry_engine(Scene&, GeometryList& out)
                                     ? pxr::UsdTimeCode(frame)
                                     : pxr::UsdTimeCode::EarliestTime();
 
-  if(geo->rebuild(Mask_Primitives)) {
-    // Destroy old geometry and retrieve from file at desired time
+  if(geo->rebuild(Mask_Primitives | Mask_Points | Mask_Matrix | Mask_Attributes)) {
+    // Destroy old geometry and retrieve from file at desired time. When only
+    // transforms or attributes animate, the same primitives are converted again
+    // from kept prototypes and only the animated parts are signalled.
     out.delete_objects();
-    geo->set_rebuild(Mask_Points | Mask_Attributes);
-    Foundry::UsdConverter::loadUsd(out, filename(), selectedPaths, time);
+    if(geo->rebuild(Mask_Primitives)) {
+      geo->set_rebuild(Mask_Points | Mask_Attributes);
+    }
+    Foundry::UsdConverter::ConversionOptions options;
+    options.splitFaceCount = static_cast<size_t>(std::max(pfmt->_splitFaceCount, 0));
+    options.mergeFaceCount = static_cast<size_t>(std::max(pfmt->_mergeFaceCount, 0));
+    options.instanceThreshold = static_cast<size_t>(std::max(pfmt->_instanceThreshold, 0));
+    options.instanceProxy = pfmt->_instanceProxy == 1
+                                ? Foundry::UsdConverter::InstanceProxy::Boxes
+                                : Foundry::UsdConverter::InstanceProxy::Points;
+    options.instanceMotionSamples = static_cast<size_t>(std::max(pfmt->_instanceMotionSamples, 0));
+    options.instanceShutter = pfmt->_instanceShutter;
+    options.crop = pfmt->_crop;
+    options.cropBox = pxr::GfRange3d(
+        pxr::GfVec3d(pfmt->_cropBox[0], pfmt->_cropBox[1], pfmt->_cropBox[2]),
+        pxr::GfVec3d(pfmt->_cropBox[3], pfmt->_cropBox[4], pfmt->_cropBox[5]));
+    options.attributeInclude = pfmt->_attributeInclude;
+    options.attributeExclude = pfmt->_attributeExclude;
+    Foundry::UsdConverter::loadUsd(out, filename(), selectedPaths, time, _cache,
+                                   options);
   }
 }
 
@@ -154,6 +203,8 @@ int usdReader::knob_changed(Knob* k)
     }
   }
   else if(k->is(ReadGeo::kReloadKnobName)) {
+    // Drop the open stage so the file is read from disk again
+    _cache.clear();
     // Reload USD file without popping up scene graph browser window
     if(!loadSceneGraph(pSceneGraphKnob, filename(), false, false)) {
       return 1;
@@ -202,6 +253,16 @@ void usdReader::append(Hash& newHash)
     float frame = static_cast<float>(geo->outputContext().frame());
     newHash.append(frame);
   }
+  appendOptions(newHash);
+}
+
+void usdReader::appendOptions(Hash& newHash)
+{
+  const auto pSceneGraphKnob = getSceneGraphKnob();
+  if(!pSceneGraphKnob) {
+    return;
+  }
+  const usdReaderFormat* pfmt = getFormat();
 
   // Append current filename to the hash
   Knob* pFileNameKnob = geo->knob(ReadGeo::kFileKnobName);
@@ -209,6 +270,20 @@ void usdReader::append(Hash& newHash)
   const char* pFilename = pFileNameKnob->get_text(&geo->uiContext());
   newHash.append(pFilename);
 
+  // Append the options that change the converted geometry
+  newHash.append(pfmt->_splitFaceCount);
+  newHash.append(pfmt->_mergeFaceCount);
+  newHash.append(pfmt->_instanceThreshold);
+  newHash.append(pfmt->_instanceProxy);
+  newHash.append(pfmt->_instanceMotionSamples);
+  newHash.append(pfmt->_instanceShutter);
+  newHash.append(pfmt->_crop);
+  for(const float value : pfmt->_cropBox) {
+    newHash.append(value);
+  }
+  newHash.append(pfmt->_attributeInclude);
+  newHash.append(pfmt->_attributeExclude);
+
   // Append all items selected in the scene graph knob to hash
   const auto selectedNodes = pSceneGraphKnob->getSelectedItems();
   for(const auto& node : selectedNodes) {
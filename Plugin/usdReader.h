@@ -37,6 +37,7 @@
 #include "DDImage/GeoReader.h"
 #include "DDImage/GeoReaderDescription.h"
 #include "DDImage/SceneItem.h"
+#include "UsdConverter/UsdConversionCache.h"
 
 class usdReaderFormat;
 
@@ -63,6 +64,12 @@ class usdReader : public DD::Image::GeoReader
   /// Modify the hash to identify changes to geometry
   void append(DD::Image::Hash& newHash) override;
 
+  /// Append everything but the frame that changes the loaded geometry
+  void appendOptions(DD::Image::Hash& newHash);
+
+  /// Get which parts of the geometry in the file animate
+  Foundry::UsdConverter::StageAnimation getAnimation();
+
   /// Get the object that handles the spec for the reader node
   usdReaderFormat* getFormat();
   const usdReaderFormat* getFormat() const;
@@ -78,6 +85,9 @@ class usdReader : public DD::Image::GeoReader
 
   bool _fileExists{ false };
   bool _validateSceneItems{ false };
+
+  /// Stage and data reused between the loads of this reader
+  Foundry::UsdConverter::ConversionCache _cache;
 };
 
 #endif  // USDREADER_H
@@ -35,11 +35,46 @@ const std::string usdReaderFormat::kReadOnEachFrameKnobName =
 const std::string usdReaderFormat::kAllObjectsKnobName = "all_objects";
 const std::string usdReaderFormat::kNodeKnobName =
     DD::Image::kSceneGraphKnobName;
+const std::string usdReaderFormat::kSplitFaceCountKnobName =
+    "split_face_count";
+const std::string usdReaderFormat::kMergeFaceCountKnobName =
+    "merge_face_count";
+const std::string usdReaderFormat::kInstanceThresholdKnobName =
+    "instance_threshold";
+const std::string usdReaderFormat::kInstanceProxyKnobName = "instance_proxy";
+const std::string usdReaderFormat::kInstanceMotionSamplesKnobName =
+    "instance_motion_samples";
+const std::string usdReaderFormat::kInstanceShutterKnobName =
+    "instance_shutter";
+const std::string usdReaderFormat::kCropKnobName = "crop";
+const std::string usdReaderFormat::kCropBoxKnobName = "crop_box";
+const std::string usdReaderFormat::kAttributeIncludeKnobName =
+    "attribute_include";
+const std::string usdReaderFormat::kAttributeExcludeKnobName =
+    "attribute_exclude";
+
+namespace
+{
+  /// Labels of the instance proxy knob, in the order of UsdConverter::InstanceProxy
+  const char* const kInstanceProxyLabels[] = {"points", "boxes", nullptr};
+}  // namespace
 
 void usdReaderFormat::append(Hash& hash)
 {
   hash.append(_readOnEachFrame);
   hash.append(_nodeNameIndex);
+  hash.append(_splitFaceCount);
+  hash.append(_mergeFaceCount);
+  hash.append(_instanceThreshold);
+  hash.append(_instanceProxy);
+  hash.append(_instanceMotionSamples);
+  hash.append(_instanceShutter);
+  hash.append(_crop);
+  for(const float value : _cropBox) {
+    hash.append(value);
+  }
+  hash.append(_attributeInclude);
+  hash.append(_attributeExclude);
 }
 
 void usdReaderFormat::knobs(Knob_Callback f)
@@ -50,6 +85,87 @@ void usdReaderFormat::knobs(Knob_Callback f)
   Tooltip(f,
           "Activate this to read the objects on each frame. This should be "
           "activated for animated objects.");
+
+  Int_knob(f, &_splitFaceCount, kSplitFaceCountKnobName.c_str(),
+           "split meshes over");
+  SetFlags(f, Knob::EARLY_STORE | Knob::STARTLINE);
+  Tooltip(f,
+          "Meshes with more faces than this are split into several objects of "
+          "neighbouring faces, so they can be processed in parallel. Each "
+          "object is named after the mesh with its chunk number. Set to 0 to "
+          "never split meshes.");
+
+  Int_knob(f, &_mergeFaceCount, kMergeFaceCountKnobName.c_str(),
+           "merge meshes under");
+  SetFlags(f, Knob::EARLY_STORE);
+  Tooltip(f,
+          "Meshes with at most this many faces are merged into shared objects, "
+          "with their transforms baked into the points. Each primitive keeps "
+          "the path of its mesh in a name attribute. Set to 0 to never merge "
+          "meshes.");
+
+  Int_knob(f, &_instanceThreshold, kInstanceThresholdKnobName.c_str(),
+           "proxy instancers over");
+  SetFlags(f, Knob::EARLY_STORE | Knob::STARTLINE);
+  Tooltip(f,
+          "Point instancers with more instances than this are drawn as a single "
+          "proxy object built from the instancer's arrays, instead of one "
+          "object per instance. Set to 0 to always expand every instance, for "
+          "example for the final render.");
+
+  Enumeration_knob(f, &_instanceProxy, kInstanceProxyLabels,
+                   kInstanceProxyKnobName.c_str(), "as");
+  SetFlags(f, Knob::EARLY_STORE);
+  Tooltip(f,
+          "points: one particle per instance, carrying its orientation, scale, "
+          "prototype index and color.\n"
+          "boxes: one box per instance, the size of the bounds of its "
+          "prototype.");
+
+  Int_knob(f, &_instanceMotionSamples, kInstanceMotionSamplesKnobName.c_str(),
+           "instance motion samples");
+  SetFlags(f, Knob::EARLY_STORE | Knob::STARTLINE);
+  Tooltip(f,
+          "Match this to the motion blur samples of the render. The instance "
+          "transforms of point instancers at all the samples of a frame are "
+          "then computed together when the first sample is read, instead of "
+          "once per sample. Set to 0 to compute every sample alone.");
+
+  Float_knob(f, &_instanceShutter, kInstanceShutterKnobName.c_str(),
+             "shutter");
+  SetFlags(f, Knob::EARLY_STORE);
+  Tooltip(f,
+          "Match this to the shutter of the render, in frames. The samples are "
+          "centred on the frame.");
+
+  Bool_knob(f, &_crop, kCropKnobName.c_str(), "crop");
+  SetFlags(f, Knob::EARLY_STORE | Knob::STARTLINE);
+  Tooltip(f,
+          "Only read the prims whose bounds overlap the crop box, and the "
+          "instances of point instancers whose prototype bounds overlap it. "
+          "Everything else is skipped before its geometry is read. Authored "
+          "extents are used where they exist.");
+
+  Box3_knob(f, _cropBox, kCropBoxKnobName.c_str(), "crop box");
+  SetFlags(f, Knob::EARLY_STORE);
+  Tooltip(f, "The crop box in world space.");
+
+  String_knob(f, &_attributeInclude, kAttributeIncludeKnobName.c_str(),
+              "include attributes");
+  SetFlags(f, Knob::EARLY_STORE | Knob::STARTLINE);
+  Tooltip(f,
+          "Space separated patterns of the attributes to read, where * matches "
+          "any characters and ? any one character. Primvars match with or "
+          "without their primvars: namespace, for example 'st display*'. "
+          "Leave empty to read every attribute. The points and topology of "
+          "the geometry are always read.");
+
+  String_knob(f, &_attributeExclude, kAttributeExcludeKnobName.c_str(),
+              "exclude");
+  SetFlags(f, Knob::EARLY_STORE);
+  Tooltip(f,
+          "Space separated patterns of the attributes not to read, applied "
+          "after the include patterns.");
 }
 
 void usdReaderFormat::extraKnobs(Knob_Callback f)
@@ -30,6 +30,8 @@
 #include "DDImage/GeoReader.h"
 #include "DDImage/GeoReaderDescription.h"
 
+#include <string>
+
 /// Implements the custom knobs for the USD format
 class usdReaderFormat : public DD::Image::GeoReaderFormat
 {
@@ -38,6 +40,16 @@ class usdReaderFormat : public DD::Image::GeoReaderFormat
   static const std::string kReadOnEachFrameKnobName;
   static const std::string kAllObjectsKnobName;
   static const std::string kNodeKnobName;
+  static const std::string kSplitFaceCountKnobName;
+  static const std::string kMergeFaceCountKnobName;
+  static const std::string kInstanceThresholdKnobName;
+  static const std::string kInstanceProxyKnobName;
+  static const std::string kInstanceMotionSamplesKnobName;
+  static const std::string kInstanceShutterKnobName;
+  static const std::string kCropKnobName;
+  static const std::string kCropBoxKnobName;
+  static const std::string kAttributeIncludeKnobName;
+  static const std::string kAttributeExcludeKnobName;
 
  public:
   usdReaderFormat() = default;
@@ -53,6 +65,26 @@ class usdReaderFormat : public DD::Image::GeoReaderFormat
  private:
   bool _readOnEachFrame = true;
   bool _allObjects = false;
+  /// Meshes with more faces are split into several objects, 0 never splits
+  int _splitFaceCount = 0;
+  /// Meshes with at most this many faces are merged into shared objects, 0 never merges
+  int _mergeFaceCount = 0;
+  /// Instancers with more instances are drawn as proxies, 0 always expands them
+  int _instanceThreshold = 0;
+  /// index of the proxy drawn for instancers over the threshold
+  int _instanceProxy = 0;
+  /// Motion blur samples whose instance transforms are computed together, 0 computes each alone
+  int _instanceMotionSamples = 0;
+  /// Shutter length in frames of the instance motion samples, centred on the frame
+  float _instanceShutter = 0.5f;
+  /// Only read the prims and instances that overlap the crop box
+  bool _crop = false;
+  /// World space crop box as x, y, z, r, t, f
+  float _cropBox[6] = {-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+  /// Space separated glob patterns of the attributes to read, empty reads all
+  std::string _attributeInclude;
+  /// Space separated glob patterns of the attributes not to read
+  std::string _attributeExclude;
   /// index of usd sdf path
   int _nodeNameIndex = 0;
 };
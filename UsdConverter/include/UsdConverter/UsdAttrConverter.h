@@ -31,9 +31,17 @@
 #include <DDImage/GeoInfo.h>
 #include <UsdConverter/UsdConverterApi.h>
 
+// Standard includes
+#include <memory>
+#include <string>
+#include <vector>
+
 // Library includes
+#include <pxr/base/tf/type.h>
 #include <pxr/pxr.h>
+#include <pxr/usd/usd/attributeQuery.h>
 #include <pxr/usd/usd/prim.h>
+#include <pxr/usd/usdGeom/pointBased.h>
 
 namespace DD
 {
@@ -50,6 +58,9 @@ namespace Foundry
   /// A collection of functions for converting USD to Nuke geometry
   namespace UsdConverter
   {
+    class ConversionCache;
+    struct ConversionContext;
+
     // PUBLIC API
     /*! Write the data from the usd attributes into the geometrylist, where Nuke stores point, attribute data as it passes through nodes
      * \param out       The geometry to modify
@@ -61,7 +72,109 @@ namespace Foundry
         DD::Image::GeometryList& out, const int obj,
         const std::vector<PXR_NS::UsdAttribute>& primvars, const PXR_NS::UsdTimeCode time);
 
+    /*! Write the data from the usd attributes into the geometrylist, reading the values
+     * through the attribute queries kept by the load's cache
+     * \param out       The geometry to modify
+     * \param obj       The index (object number) into the geometry to modify
+     * \param primvars  The attributes to convert
+     * \param ctx       State shared by the converters of the load
+     */
+    FN_USDCONVERTER_API void ConvertUsdAttributes(
+        DD::Image::GeometryList& out, const int obj,
+        const std::vector<PXR_NS::UsdAttribute>& primvars,
+        const ConversionContext& ctx);
+
     // PRIVATE API
+    /// A Nuke attribute converted outside of a geometry list, for objects assembled from several prims
+    struct ConvertedAttribute
+    {
+      std::string name;
+      DD::Image::GroupType group;
+      std::shared_ptr<DD::Image::Attribute> attribute;
+    };
+
+    /*! Convert usd attributes the same way as into a geometry list object, but into
+     * attributes of their own
+     * \param primvars  The attributes to convert
+     * \param time      Timecode to fetch the data at
+     * \return The converted attributes
+     */
+    std::vector<ConvertedAttribute> ConvertUsdAttributes(
+        const std::vector<PXR_NS::UsdAttribute>& primvars,
+        const PXR_NS::UsdTimeCode time);
+
+    /*! Convert usd attributes into attributes of their own, reading the values
+     * through the attribute queries kept by the load's cache
+     * \param primvars  The attributes to convert
+     * \param ctx       State shared by the converters of the load
+     * \return The converted attributes
+     */
+    std::vector<ConvertedAttribute> ConvertUsdAttributes(
+        const std::vector<PXR_NS::UsdAttribute>& primvars,
+        const ConversionContext& ctx);
+
+    /*! Convert one usd attribute into an attribute of its own, the same way as into
+     * a geometry list object
+     * \param fromAttr  The attribute to convert
+     * \param time      Timecode to fetch the data at
+     * \param toAttr    Output converted attribute
+     * \param cache     Cache of the reader whose attribute queries are read through,
+     *                  null if the caller doesn't keep one
+     * \param elementSize Optional output number of values per element
+     * \return False if the attribute has no Nuke counterpart
+     */
+    bool ConvertUsdAttribute(const PXR_NS::UsdAttribute& fromAttr,
+                             const PXR_NS::UsdTimeCode time,
+                             ConvertedAttribute* toAttr,
+                             ConversionCache* cache = nullptr,
+                             int* elementSize = nullptr);
+
+    /*! Get the attributes of a prim that can have a Nuke counterpart: its primvars
+     * and the few builtin attributes that are converted, such as the normals,
+     * velocities and widths, that have values. The prim's other schema
+     * attributes are never converted, so their values aren't resolved.
+     * \param prim      Prim to convert
+     * \return The candidate attributes
+     */
+    std::vector<PXR_NS::UsdAttribute> ConvertibleAttributes(
+        const PXR_NS::UsdPrim& prim);
+
+    /// A read-only view of a contiguous range of a USD array, which must outlive it
+    template <class T>
+    class ArraySpan
+    {
+     public:
+      ArraySpan() = default;
+
+      /// View of the whole array
+      ArraySpan(const PXR_NS::VtArray<T>& array)
+          : _data(array.cdata()), _size(array.size())
+      {
+      }
+
+      /// View of the stride elements starting at offset * stride, empty if out of range
+      ArraySpan(const PXR_NS::VtArray<T>& array, size_t offset, size_t stride)
+      {
+        const size_t end = (offset + 1) * stride;
+        if(end <= array.size()) {
+          _data = array.cdata() + offset * stride;
+          _size = stride;
+        }
+      }
+
+      const T* begin() const { return _data; }
+      const T* end() const { return _data + _size; }
+      const T* cbegin() const { return begin(); }
+      const T* cend() const { return end(); }
+      size_t size() const { return _size; }
+      bool empty() const { return _size == 0; }
+      const T& operator[](size_t i) const { return _data[i]; }
+
+     private:
+      const T* _data = nullptr;
+      size_t _size = 0;
+    };
+
     /// Parameters for filling out data on primitives
     struct ColorUvData
     {
@@ -69,15 +182,34 @@ namespace Foundry
       PXR_NS::VtArray<PXR_NS::GfVec3f> color;
       PXR_NS::VtFloatArray opacity;
       PXR_NS::VtUIntArray faceVertexIndices;
+      /// Indices into the uvs of an indexed primvar, empty when the uvs are flattened
+      PXR_NS::VtIntArray uvIndices;
       int uvElementSize = 1;
       int colorElementSize = 1;
       int opacityElementSize = 1;
       DD::Image::GroupType uvGroup = DD::Image::Group_Vertices;
       DD::Image::GroupType colorGroup = DD::Image::Group_None;
       DD::Image::GroupType opacityGroup = DD::Image::Group_None;
+    };
+
+    /// View of color and uv data, or of the slice of it that belongs to one instance
+    struct ColorUvSpans
+    {
+      ArraySpan<PXR_NS::GfVec2f> uvs;
+      ArraySpan<PXR_NS::GfVec3f> color;
+      ArraySpan<float> opacity;
+      ArraySpan<unsigned int> faceVertexIndices;
+      /// Indices into the uvs, empty when the uvs are flattened
+      ArraySpan<int> uvIndices;
+      DD::Image::GroupType uvGroup = DD::Image::Group_Vertices;
+      DD::Image::GroupType colorGroup = DD::Image::Group_None;
+      DD::Image::GroupType opacityGroup = DD::Image::Group_None;
 
-      ColorUvData() = default;
-      ColorUvData(const ColorUvData& other, int offset);
+      ColorUvSpans() = default;
+      /// View of all the data
+      ColorUvSpans(const ColorUvData& data);
+      /// View of the elementSize values of one instance, the uvs have to be flattened
+      ColorUvSpans(const ColorUvData& data, size_t offset);
     };
 
     /// Map to Nuke attribute type (Float, Vector3, Matrix, etc)
@@ -92,11 +224,51 @@ namespace Foundry
      */
     PXR_NS::TfToken ConvertName(const PXR_NS::UsdAttribute& fromAttr);
 
+    /// The Nuke attribute a USD attribute is converted to
+    struct AttributeTarget
+    {
+      /// False if the attribute has no Nuke counterpart
+      bool convert = false;
+      PXR_NS::TfToken name;
+      DD::Image::GroupType group = DD::Image::Group_None;
+      DD::Image::AttribType type = DD::Image::INVALID_ATTRIB;
+    };
+
+    /*! Get the Nuke attribute an attribute is converted to. Attributes without a
+     * Nuke counterpart are rejected by name, before their type or interpolation
+     * is read.
+     * \param fromAttr  USD attribute
+     * \return The Nuke name, group and type
+     */
+    AttributeTarget ResolveAttributeTarget(const PXR_NS::UsdAttribute& fromAttr);
+
+    /*! Resolve info of the values of an attribute, and of the indices of an indexed
+     * primvar. Made once per attribute and stage, so later reads only fetch the samples.
+     */
+    struct AttributeQueries
+    {
+      explicit AttributeQueries(const PXR_NS::UsdAttribute& attr);
+
+      PXR_NS::UsdAttributeQuery values;
+      /// Invalid unless the attribute is an indexed primvar
+      PXR_NS::UsdAttributeQuery indices;
+      /// Number of values per element, which each index selects together
+      int elementSize = 1;
+    };
+
     /// Compute attribute, flattening indexed values if necessary
     template <class DEST>
     void ComputePrimvar(DEST& value, const PXR_NS::UsdAttribute& attr,
                         PXR_NS::UsdTimeCode time);
 
+    /*! Check whether ComputePrimvar can read attributes of a value type into DEST,
+     * from a table of the supported conversions built once per DEST
+     * \param source    Value type of the attribute
+     * \return True if the type is DEST or its values can be copied into DEST
+     */
+    template <class DEST>
+    bool CanComputePrimvar(const PXR_NS::TfType& source);
+
     /*! Add points to geometry
      * \param out       Geometry to modify
      * \param obj       GeoInfo index to modify
@@ -108,15 +280,41 @@ namespace Foundry
                          const PXR_NS::UsdAttribute& fromAttr,
                          const PXR_NS::UsdTimeCode time);
 
+    /*! Add the points of a point based prim to geometry. At sub-frame times the points
+     * are extrapolated from the authored sample when velocities are available.
+     * \param out       Geometry to modify
+     * \param obj       GeoInfo index to modify
+     * \param fromPrim  Prim to get the point data from
+     * \param ctx       State shared by the converters of the load
+     * \return Number of points added
+     */
+    size_t ConvertPoints(DD::Image::GeometryList& out, const int obj,
+                         const PXR_NS::UsdGeomPointBased& fromPrim,
+                         const ConversionContext& ctx);
+
+    /*! Get the points of a point based prim, with the same sub-frame handling as
+     * when they are added to geometry
+     * \param toPoints  Output points
+     * \param fromPrim  Prim to get the point data from
+     * \param ctx       State shared by the converters of the load
+     * \return Number of points
+     */
+    size_t ConvertPoints(std::vector<DD::Image::Vector3>& toPoints,
+                         const PXR_NS::UsdGeomPointBased& fromPrim,
+                         const ConversionContext& ctx);
+
     /*! Convert USD attributes that don't map to Nuke ones directly
-     * \param data      Output collected data for color and uvs
-     * \param attrs     The attributes to convert
-     * \param time      Timecode to fetch the data at
+     * \param data          Output collected data for color and uvs
+     * \param attrs         The attributes to convert
+     * \param time          Timecode to fetch the data at
+     * \param keepIndexed   Keep the values and indices of indexed uvs apart instead of flattening them
+     * \param cache         Cache keeping the attribute queries between loads, may be null
      * \return Remaining attributes
      */
     std::vector<PXR_NS::UsdAttribute> ConvertMismatchedAttributes(
         ColorUvData& data, const std::vector<PXR_NS::UsdAttribute>& attrs,
-        const PXR_NS::UsdTimeCode time);
+        const PXR_NS::UsdTimeCode time, bool keepIndexed = false,
+        ConversionCache* cache = nullptr);
 
     /*! Copy the color and opacity into an attribute
      * \param Cf                  Color attribute for Nuke
@@ -126,11 +324,12 @@ namespace Foundry
      * \param opactiyGroup        GroupType of opacity
      * \param faceVertexIndices   Vertex -> point number array
      */
-    void ConvertColor(DD::Image::Attribute& Cf, const PXR_NS::VtArray<PXR_NS::GfVec3f>& color,
+    void ConvertColor(DD::Image::Attribute& Cf,
+                      ArraySpan<PXR_NS::GfVec3f> color,
                       DD::Image::GroupType colorGroup,
-                      const PXR_NS::VtFloatArray& opacity,
+                      ArraySpan<float> opacity,
                       DD::Image::GroupType opacityGroup,
-                      const PXR_NS::VtUIntArray& faceVertexIndices);
+                      ArraySpan<unsigned int> faceVertexIndices);
 
     /*! Add the prim path as the name attribute
      * \param out       Geometry to modify
@@ -140,8 +339,70 @@ namespace Foundry
     void ConvertPrimPath(DD::Image::GeometryList& out, int obj,
                          const PXR_NS::UsdPrim& prim);
 
+    /*! Add the prim path and a chunk id as the name attribute, for the objects a
+     * prim was split into
+     * \param out       Geometry to modify
+     * \param obj       GeoInfo index to modify
+     * \param prim      Prim whose path to add
+     * \param chunk     Index of the chunk of the prim
+     */
+    void ConvertPrimPath(DD::Image::GeometryList& out, int obj,
+                         const PXR_NS::UsdPrim& prim, size_t chunk);
+
+    /// Names of the Nuke attributes that USD attributes are converted to
+    const std::vector<const char*>& ConvertedAttributeNames();
+
+    /*! Copy elements of an attribute into another one of the same type
+     * \param from      Attribute to copy from
+     * \param indices   Element of from to copy into each element of to, null copies all of them
+     * \param to        Attribute to fill. Can be from itself when no index is smaller than its position.
+     */
+    void CopyAttributeElements(const DD::Image::Attribute& from,
+                               const std::vector<unsigned>* indices,
+                               DD::Image::Attribute& to);
+
+    /*! Copy a range of elements of an attribute into another one of the same type,
+     * which is left empty if the range is out of bounds
+     * \param from      Attribute to copy from
+     * \param begin     First element to copy
+     * \param end       One past the last element to copy
+     * \param to        Attribute to fill
+     */
+    void CopyAttributeRange(const DD::Image::Attribute& from, size_t begin,
+                            size_t end, DD::Image::Attribute& to);
+
+    /*! Append all the elements of an attribute to another one of the same type
+     * \param from      Attribute to copy from
+     * \param to        Attribute to append to
+     */
+    void AppendAttributeElements(const DD::Image::Attribute& from,
+                                 DD::Image::Attribute& to);
+
     /// Fill Nuke attribute with uvs
-    void ConvertUvs(DD::Image::Attribute& toAttr, const PXR_NS::VtVec2fArray& uvs);
+    void ConvertUvs(DD::Image::Attribute& toAttr,
+                    ArraySpan<PXR_NS::GfVec2f> uvs);
+
+    /*! Fill Nuke attribute with indexed uvs, flattening them as they are written
+     * \param toAttr    Attribute to fill, with one element per index
+     * \param uvs       Uv values
+     * \param indices   Index of the value of each element, out of range indices give zero uvs
+     */
+    void ConvertUvs(DD::Image::Attribute& toAttr,
+                    ArraySpan<PXR_NS::GfVec2f> uvs, ArraySpan<int> indices);
+
+    /*! Find the value index of each point when every vertex of a point indexes the
+     * same value, so a vertex primvar can be stored per point instead
+     * \param values            Values of the primvar
+     * \param vertexIndices     Value index of each vertex
+     * \param faceVertexIndices Point of each vertex
+     * \param pointCount        Number of points
+     * \param pointIndices      Output value index of each point, -1 for unused points
+     * \return False if some point's vertices use different values
+     */
+    bool FindPointIndices(ArraySpan<PXR_NS::GfVec2f> values,
+                          ArraySpan<int> vertexIndices,
+                          ArraySpan<unsigned int> faceVertexIndices,
+                          size_t pointCount, PXR_NS::VtIntArray* pointIndices);
 
     /*! Convert to Matrix4
      * \param from      A USD matrix class instance
@@ -166,7 +427,7 @@ namespace Foundry
      * \param data      Color and uv data to fill from
      */
     void ConvertColorUvs(DD::Image::GeometryList& out, const int obj,
-                         const ColorUvData& data);
+                         const ColorUvSpans& data);
 
     /*! Convert from USD arrays (VtFloatArray, etc) and copy the data into the attributes
      * \param toAttr    Attribute to fill with data
@@ -189,7 +450,7 @@ namespace Foundry
      */
     size_t PromoteAttribute(DD::Image::GroupType target,
                             DD::Image::GroupType source,
-                            const PXR_NS::VtUIntArray& faceVertexIndices,
+                            ArraySpan<unsigned int> faceVertexIndices,
                             size_t index);
 
     /*! Get a copy of the subset of the array
@@ -0,0 +1,78 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Header file for choosing which USD attributes a load converts
+ */
+
+#ifndef USD_ATTRIBUTE_FILTER_H
+#define USD_ATTRIBUTE_FILTER_H
+
+// Library includes
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/attribute.h>
+
+// Standard includes
+#include <string>
+#include <vector>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /*! Check whether a name matches a glob pattern
+     * \param pattern   Pattern where * matches any characters and ? any one character
+     * \param name      Name to match
+     * \return True if the whole name matches
+     */
+    bool MatchGlob(const std::string& pattern, const std::string& name);
+
+    /*! Include and exclude glob patterns of the attributes to convert. An attribute
+     * is matched by its full name, and primvars by their name without the primvars:
+     * namespace too.
+     */
+    class AttributeFilter
+    {
+     public:
+      /*! \param include   Space separated patterns of the attributes to convert, empty converts all
+       * \param exclude   Space separated patterns of the attributes not to convert
+       */
+      AttributeFilter(const std::string& include, const std::string& exclude);
+
+      /// Check whether an attribute is converted
+      bool operator()(const PXR_NS::UsdAttribute& attr) const;
+
+      /*! Keep the attributes that are converted. The attributes the conversion
+       * needs for the topology are always kept.
+       */
+      std::vector<PXR_NS::UsdAttribute> filter(
+          const std::vector<PXR_NS::UsdAttribute>& attrs) const;
+
+     private:
+      std::vector<std::string> _include;
+      std::vector<std::string> _exclude;
+    };
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
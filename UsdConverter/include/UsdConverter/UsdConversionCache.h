@@ -0,0 +1,193 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Header file for the UsdConverter cache kept alive between loads
+
+ A reader owns one ConversionCache and passes it to every load, so the
+ stage and any data that doesn't change between frames or sub-frame samples
+ is only read once.
+ */
+
+#ifndef USD_CONVERSION_CACHE_H
+#define USD_CONVERSION_CACHE_H
+
+#include <UsdConverter/UsdAttrConverter.h>
+#include <UsdConverter/UsdConverterApi.h>
+#include <UsdConverter/UsdHierarchy.h>
+#include <UsdConverter/UsdInstancerPrototypes.h>
+#include <UsdConverter/UsdMotionSamples.h>
+
+// Standard includes
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Library includes
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/usd/stage.h>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /// Data kept between the loads of one reader. All methods are thread safe.
+    class FN_USDCONVERTER_API ConversionCache
+    {
+     public:
+      ConversionCache() = default;
+      ConversionCache(const ConversionCache&) = delete;
+      ConversionCache& operator=(const ConversionCache&) = delete;
+
+      /*! Get the stage of a file opened with a population mask, the stage is only
+       * reopened when the file or the mask paths change
+       * \param filename  USD file to open
+       * \param maskPaths Paths of the population mask
+       * \return The stage, null if the file couldn't be opened
+       */
+      PXR_NS::UsdStageRefPtr stage(const std::string& filename,
+                                   const std::vector<std::string>& maskPaths);
+
+      /// Drop everything, for example when the file is reloaded from disk
+      void clear();
+
+      /*! Get which parts of the converted geometry of a file can change over time,
+       * only checked once per stage
+       * \param filename  USD file to open
+       * \param maskPaths Paths of the population mask
+       * \return The animated parts, everything if the file couldn't be opened
+       */
+      StageAnimation animation(const std::string& filename,
+                               const std::vector<std::string>& maskPaths);
+
+      /*! Get the point sample of a prim that sub-frame points are extrapolated from,
+       * reading it only if a different sample was cached for the prim
+       * \param fromPrim  Point based prim
+       * \param time      Requested sub-frame time
+       * \return The sample, null if the points can't be extrapolated at this time
+       */
+      std::shared_ptr<const PointSamples> pointSamples(
+          const PXR_NS::UsdGeomPointBased& fromPrim, PXR_NS::UsdTimeCode time);
+
+      /*! Get the authored point samples bracketing a time, shared with earlier
+       * loads when the sample times match so only new samples are read
+       * \param fromPrim  Point based prim
+       * \param time      Requested time
+       * \return The samples, null if the points don't need interpolating at this time
+       */
+      std::shared_ptr<const BracketingSamples> bracketingSamples(
+          const PXR_NS::UsdGeomPointBased& fromPrim, PXR_NS::UsdTimeCode time);
+
+      /*! Get the instance transforms of a point instancer at the shutter times of
+       * a frame, all computed in one call when the first of them is requested
+       * \param instancer Point instancer
+       * \param times     Shutter times of the frame
+       * \return The transforms, null if they couldn't be computed
+       */
+      std::shared_ptr<const InstanceTransformSamples> instanceTransforms(
+          const PXR_NS::UsdGeomPointInstancer& instancer,
+          const std::vector<double>& times);
+
+      /*! Get a prototype prim converted by an earlier load
+       * \param instancer   Path of the instancer
+       * \param prim        Path of the prototype prim
+       * \param fingerprint Fingerprint of what the prototype is converted from
+       * \return The prototype, null if none was kept with this fingerprint
+       */
+      std::shared_ptr<const PrototypeTemplate> prototypeTemplate(
+          const PXR_NS::SdfPath& instancer, const PXR_NS::SdfPath& prim,
+          size_t fingerprint);
+
+      /*! Keep a converted prototype prim for the following loads
+       * \param instancer   Path of the instancer
+       * \param prim        Path of the prototype prim
+       * \param fingerprint Fingerprint of what the prototype is converted from
+       * \param prototype   The converted prototype
+       */
+      void setPrototypeTemplate(
+          const PXR_NS::SdfPath& instancer, const PXR_NS::SdfPath& prim,
+          size_t fingerprint, std::shared_ptr<const PrototypeTemplate> prototype);
+
+      /*! Get the resolved prototypes of a point instancer, which are only resolved
+       * once per stage as relationships can't be time sampled
+       * \param instancer Point instancer
+       * \return The prototypes
+       */
+      std::shared_ptr<const InstancerPrototypes> instancerPrototypes(
+          const PXR_NS::UsdGeomPointInstancer& instancer);
+
+      /*! Get the queries of an attribute's values, made once per stage and then
+       * shared by every load
+       * \param attr      Attribute to read
+       * \return The queries
+       */
+      std::shared_ptr<const AttributeQueries> attributeQueries(
+          const PXR_NS::UsdAttribute& attr);
+
+     private:
+      /// Drop the attribute queries of the stage, called with _mutex held
+      void clearStageData();
+
+      std::mutex _mutex;
+      std::string _filename;
+      std::vector<std::string> _maskPaths;
+      PXR_NS::UsdStageRefPtr _stage;
+      /// Animated parts of the stage, checked on first use
+      std::unique_ptr<StageAnimation> _animation;
+      /// Only the latest sample per prim is kept, older frames aren't revisited by motion blur
+      std::unordered_map<PXR_NS::SdfPath, std::shared_ptr<const PointSamples>,
+                         PXR_NS::SdfPath::Hash>
+          _pointSamples;
+      /// Latest bracketing samples per prim, their upper sample becomes the next lower one
+      std::unordered_map<PXR_NS::SdfPath,
+                         std::shared_ptr<const BracketingSamples>,
+                         PXR_NS::SdfPath::Hash>
+          _bracketingSamples;
+      /// Instance transforms of the latest frame per instancer
+      std::unordered_map<PXR_NS::SdfPath,
+                         std::shared_ptr<const InstanceTransformSamples>,
+                         PXR_NS::SdfPath::Hash>
+          _instanceTransforms;
+      std::unordered_map<PXR_NS::SdfPath,
+                         std::shared_ptr<const InstancerPrototypes>,
+                         PXR_NS::SdfPath::Hash>
+          _instancerPrototypes;
+      /// Latest converted prototypes per instancer and prototype prim, with their fingerprints
+      std::unordered_map<std::pair<PXR_NS::SdfPath, PXR_NS::SdfPath>,
+                         std::pair<size_t, std::shared_ptr<const PrototypeTemplate>>,
+                         PathPairHash>
+          _prototypeTemplates;
+      /// Queries are looked up for every attribute, so they don't wait on the other caches
+      std::mutex _queriesMutex;
+      std::unordered_map<PXR_NS::SdfPath, std::shared_ptr<const AttributeQueries>,
+                         PXR_NS::SdfPath::Hash>
+          _attributeQueries;
+    };
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
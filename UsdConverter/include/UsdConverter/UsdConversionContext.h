@@ -0,0 +1,112 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Header file for the state shared by the converters during a load
+ */
+
+#ifndef USD_CONVERSION_CONTEXT_H
+#define USD_CONVERSION_CONTEXT_H
+
+#include <UsdConverter/UsdAttrConverter.h>
+#include <UsdConverter/UsdAttributeFilter.h>
+#include <UsdConverter/UsdConversionCache.h>
+#include <UsdConverter/UsdConversionOptions.h>
+#include <UsdConverter/UsdHierarchy.h>
+
+// Library includes
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/timeCode.h>
+
+// Standard includes
+#include <memory>
+#include <vector>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /// State shared by all the converters of one load
+    struct ConversionContext
+    {
+      explicit ConversionContext(
+          PXR_NS::UsdTimeCode time = PXR_NS::UsdTimeCode::Default())
+          : time(time)
+      {
+      }
+
+      /*! Get the world transform of a prim, from the shared transforms if they were
+       * computed for this load, or else computed for the prim alone
+       * \param prim      Prim to get the transform of
+       * \return World transform in Nuke's axis convention
+       */
+      PXR_NS::GfMatrix4d worldTransform(const PXR_NS::UsdPrim& prim) const
+      {
+        PXR_NS::GfMatrix4d world;
+        if(transforms && transforms->get(prim.GetPath(), &world)) {
+          return world;
+        }
+        return ComputeWorldTransform(prim, time);
+      }
+
+      /*! Get the attributes of a prim that can be converted, with the constant
+       * primvars it inherits if they were found for this load
+       * \param prim      Prim to convert
+       * \return The candidate attributes, before the attribute filter
+       */
+      std::vector<PXR_NS::UsdAttribute> primAttributes(
+          const PXR_NS::UsdPrim& prim) const
+      {
+        std::vector<PXR_NS::UsdAttribute> attrs = ConvertibleAttributes(prim);
+        if(inheritedPrimvars) {
+          inheritedPrimvars->append(prim, &attrs);
+        }
+        return attrs;
+      }
+
+      /*! Keep the attributes this load converts
+       * \param attrs     Attributes of a prim
+       * \return The attributes that pass the attribute filter, all of them without one
+       */
+      std::vector<PXR_NS::UsdAttribute> filterAttributes(
+          const std::vector<PXR_NS::UsdAttribute>& attrs) const
+      {
+        return attributeFilter ? attributeFilter->filter(attrs) : attrs;
+      }
+
+      /// Timecode to fetch the data at
+      PXR_NS::UsdTimeCode time;
+      /// World transforms of the stage's prims, null if not computed for this load
+      const WorldTransforms* transforms = nullptr;
+      /// Constant primvars inherited from ancestors, null if not found for this load
+      const InheritedPrimvars* inheritedPrimvars = nullptr;
+      /// Data kept between loads by the reader, null if the caller doesn't keep one
+      ConversionCache* cache = nullptr;
+      /// Options of the load
+      ConversionOptions options;
+      /// Attributes to convert, compiled from the options. Null converts all of them.
+      std::shared_ptr<const AttributeFilter> attributeFilter;
+    };
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
@@ -0,0 +1,79 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Header file for the user options of a UsdConverter load
+ */
+
+#ifndef USD_CONVERSION_OPTIONS_H
+#define USD_CONVERSION_OPTIONS_H
+
+// Library includes
+#include <pxr/base/gf/range3d.h>
+#include <pxr/pxr.h>
+
+// Standard includes
+#include <cstddef>
+#include <string>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /// How the instances of instancers over the instance threshold are drawn
+    enum class InstanceProxy
+    {
+      /// One particle per instance, with the orientations, scales, prototype indices and colors
+      Points,
+      /// One box per instance, the size of its prototype's bounds
+      Boxes
+    };
+
+    /// Options that change the geometry a load produces, set from the reader's knobs
+    struct ConversionOptions
+    {
+      /// Meshes with more faces than this are split into several objects, 0 never splits
+      size_t splitFaceCount = 0;
+      /// Meshes with at most this many faces are merged into shared objects, 0 never merges
+      size_t mergeFaceCount = 0;
+      /// Instancers with more instances than this are drawn as one proxy object, 0 always expands them
+      size_t instanceThreshold = 0;
+      /// Proxy drawn for instancers over the instance threshold
+      InstanceProxy instanceProxy = InstanceProxy::Points;
+      /// Motion blur samples per frame whose instance transforms are computed together, 0 computes each time alone
+      size_t instanceMotionSamples = 0;
+      /// Length of the shutter in frames, centred on the frame
+      double instanceShutter = 0.5;
+      /// Only convert the prims and instances whose bounds overlap the crop box
+      bool crop = false;
+      /// World space crop box, in Nuke's axis convention
+      PXR_NS::GfRange3d cropBox;
+      /// Space separated glob patterns of the attributes to convert, empty converts all
+      std::string attributeInclude;
+      /// Space separated glob patterns of the attributes not to convert
+      std::string attributeExclude;
+    };
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
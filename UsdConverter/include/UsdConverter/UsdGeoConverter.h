@@ -34,6 +34,7 @@
 #ifndef USD_CONVERTER_H
 #define USD_CONVERTER_H
 
+#include <UsdConverter/UsdConversionOptions.h>
 #include <UsdConverter/UsdConverterApi.h>
 
 // Standard includes
@@ -60,6 +61,16 @@ namespace Foundry
   /// A collection of functions for converting USD to Nuke geometry
   namespace UsdConverter
   {
+    class ConversionCache;
+    struct ConversionContext;
+
+    /// Rotation of each instance of an instancer proxy drawn as points
+    const char* const kOrientAttrName = "orient";
+    /// Scale of each instance of an instancer proxy drawn as points
+    const char* const kScaleAttrName = "scale";
+    /// Prototype index of each instance of an instancer proxy
+    const char* const kProtoIndexAttrName = "protoIndex";
+
     // PUBLIC API
     /*! Load a USD file into Nuke, optionally with a mask
      * \param out       Geometry output list
@@ -72,14 +83,32 @@ namespace Foundry
                                      const std::vector<std::string>& maskPaths,
                                      const PXR_NS::UsdTimeCode time);
 
+    /*! Load a USD file into Nuke, keeping the stage and reusable data in a cache
+     * \param out       Geometry output list
+     * \param filename  Input file to load
+     * \param maskPaths Collection of mask paths, if empty no geometry is loaded
+     * \param time      Timecode to fetch the data at
+     * \param cache     Cache kept alive by the caller between loads of the same reader
+     * \param options   Options changing the produced geometry
+     */
+    FN_USDCONVERTER_API void loadUsd(
+        DD::Image::GeometryList& out, const std::string& filename,
+        const std::vector<std::string>& maskPaths,
+        const PXR_NS::UsdTimeCode time, ConversionCache& cache,
+        const ConversionOptions& options = ConversionOptions());
+
     /*! Convert geometry in the stage into Nuke geometry
      * \param out       Geometry output list
      * \param stage     Input USD stage
      * \param time      Timecode to fetch the data at
+     * \param cache     Cache kept between loads, or null
+     * \param options   Options changing the produced geometry
      */
     FN_USDCONVERTER_API void convertUsdGeometry(
         DD::Image::GeometryList& out, PXR_NS::UsdStageRefPtr stage,
-        const PXR_NS::UsdTimeCode time = PXR_NS::UsdTimeCode::Default());
+        const PXR_NS::UsdTimeCode time = PXR_NS::UsdTimeCode::Default(),
+        ConversionCache* cache = nullptr,
+        const ConversionOptions& options = ConversionOptions());
 
     /*! [Template] Convert USD_PRIM topology to NUKE_PRIM topology
      * \param fromPrim  Input USD prim
@@ -120,11 +149,11 @@ namespace Foundry
     /*! Identify the USD prim type and if supported convert it to Nuke geometry
      * \param out       Geometry output list
      * \param prim      Input USD prim
-     * \param time      Timecode to fetch the data at
+     * \param ctx       State shared by the converters of the load
      * \return Nuke geometry list index that was added, -1 if nothing was added
      */
     int addUsdPrim(DD::Image::GeometryList& out, const PXR_NS::UsdPrim& prim,
-                   const PXR_NS::UsdTimeCode time);
+                   const ConversionContext& ctx);
 
   }  //namespace UsdConverter
 }  // namespace Foundry
@@ -0,0 +1,59 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Header file for UsdConverter decoding of half float arrays
+
+ Caches often store colors, velocities and uvs as half floats. Their Nuke
+ attributes hold floats, so the halves are decoded in one pass over the flat
+ array of components, eight at a time on CPUs with F16C.
+ */
+
+#ifndef USD_HALF_FLOATS_H
+#define USD_HALF_FLOATS_H
+
+// Library includes
+#include <pxr/base/gf/half.h>
+#include <pxr/pxr.h>
+
+// Standard includes
+#include <cstddef>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /*! Decode half floats to floats, in parallel chunks for large arrays
+     * \param from      Half floats. The components of half vectors are tightly
+     *                  packed, so they are decoded as one flat array.
+     * \param count     Number of half floats
+     * \param out       Output floats, space for count floats
+     */
+    void DecodeHalfs(const PXR_NS::GfHalf* from, size_t count, float* out);
+
+    /// Check whether DecodeHalfs uses the F16C instructions on this CPU
+    bool HasHalfDecodeInstructions();
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
@@ -0,0 +1,184 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Header file for UsdConverter stage hierarchy passes
+
+ The hierarchy is flattened once per load into an array of prims ordered by
+ depth, so that per prim values that depend on the ancestors (such as the
+ world transform or the inherited primvars) can be computed level by level
+ with each level in parallel.
+ */
+
+#ifndef USD_HIERARCHY_H
+#define USD_HIERARCHY_H
+
+#include <UsdConverter/UsdConverterApi.h>
+
+// Standard includes
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Library includes
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/usd/prim.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/usdGeom/primvar.h>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /// Prims of a stage flattened into levels, parents always precede their children
+    class PrimHierarchy
+    {
+     public:
+      /// Index of the (not stored) pseudo root, used as parent of the root prims
+      static const size_t kNoParent;
+
+      PrimHierarchy() = default;
+
+      /*! Traverse the stage once and record every prim with its parent
+       * \param stage     Stage to traverse
+       */
+      explicit PrimHierarchy(const PXR_NS::UsdStageRefPtr& stage);
+
+      /// Number of prims in the hierarchy
+      size_t size() const { return _prims.size(); }
+
+      /// Prim at index
+      const PXR_NS::UsdPrim& prim(size_t index) const { return _prims[index]; }
+
+      /// Index of the parent of the prim at index, or kNoParent for root prims
+      size_t parent(size_t index) const { return _parents[index]; }
+
+      /// Prim indices grouped by depth, level 0 holds the root prims
+      const std::vector<std::vector<size_t>>& levels() const { return _levels; }
+
+      /*! Find the index of a prim
+       * \param path      Path of the prim to find
+       * \param index     Output index of the prim
+       * \return False if the prim wasn't traversed
+       */
+      bool find(const PXR_NS::SdfPath& path, size_t* index) const;
+
+     private:
+      std::vector<PXR_NS::UsdPrim> _prims;
+      std::vector<size_t> _parents;
+      std::vector<std::vector<size_t>> _levels;
+      std::unordered_map<PXR_NS::SdfPath, size_t, PXR_NS::SdfPath::Hash> _indices;
+    };
+
+    /// World transforms of all the prims in a hierarchy, shared by the converters of a load
+    class WorldTransforms
+    {
+     public:
+      WorldTransforms() = default;
+
+      /*! Compute the world transforms in one top-down pass over the hierarchy.
+       * The stage up-axis rotation is folded into the root, so the results are
+       * already in Nuke's axis convention.
+       * \param hierarchy Flattened stage prims
+       * \param upAxis    Up axis of the stage
+       * \param time      Timecode to fetch the transforms at
+       */
+      WorldTransforms(const PrimHierarchy& hierarchy,
+                      const PXR_NS::TfToken& upAxis,
+                      PXR_NS::UsdTimeCode time);
+
+      /*! Get the world transform of a prim
+       * \param path      Path of the prim
+       * \param world     Output world transform
+       * \return False if the prim wasn't part of the hierarchy
+       */
+      bool get(const PXR_NS::SdfPath& path, PXR_NS::GfMatrix4d* world) const;
+
+      /// World transform of the prim at a hierarchy index
+      const PXR_NS::GfMatrix4d& at(size_t index) const { return _worlds[index]; }
+
+     private:
+      const PrimHierarchy* _hierarchy = nullptr;
+      std::vector<PXR_NS::GfMatrix4d> _worlds;
+    };
+
+    /// Constant primvars that the prims of a hierarchy inherit from their ancestors
+    class InheritedPrimvars
+    {
+     public:
+      InheritedPrimvars() = default;
+
+      /*! Find the inheritable primvars in one top-down pass over the hierarchy. Each
+       * prim only checks its own primvars against those of its parent, and shares
+       * its parent's set when it adds none.
+       * \param hierarchy Flattened stage prims
+       */
+      explicit InheritedPrimvars(const PrimHierarchy& hierarchy);
+
+      /*! Add the primvars a prim inherits to its attributes, except those the
+       * attributes already have
+       * \param prim      Prim of the attributes
+       * \param attrs     Attributes of the prim, appended to
+       */
+      void append(const PXR_NS::UsdPrim& prim,
+                  std::vector<PXR_NS::UsdAttribute>* attrs) const;
+
+     private:
+      using Primvars = std::vector<PXR_NS::UsdGeomPrimvar>;
+
+      const PrimHierarchy* _hierarchy = nullptr;
+      /// What the descendants of each prim inherit, null if nothing
+      std::vector<std::shared_ptr<const Primvars>> _inheritable;
+    };
+
+    /*! Compute the world transform of a single prim, including the stage up-axis rotation.
+     * Used when no WorldTransforms were computed for the load.
+     * \param prim      Prim to compute the transform for
+     * \param time      Timecode to fetch the transform at
+     * \return World transform in Nuke's axis convention
+     */
+    PXR_NS::GfMatrix4d ComputeWorldTransform(const PXR_NS::UsdPrim& prim,
+                                             PXR_NS::UsdTimeCode time);
+
+    /// Parts of the converted geometry of a stage that can change over time
+    struct StageAnimation
+    {
+      /// Faces, instances or particles are added or removed
+      bool topology = false;
+      /// Points move
+      bool points = false;
+      /// Instances move, which instancer proxies bake into their points
+      bool instances = false;
+    };
+
+    /*! Find which parts of the converted geometry of a stage can change over time,
+     * transforms and attributes are assumed to always do
+     * \param stage     Stage to check
+     * \return The animated parts
+     */
+    StageAnimation ComputeStageAnimation(const PXR_NS::UsdStageRefPtr& stage);
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
@@ -0,0 +1,137 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Header file for resolving the prototypes of point instancers
+
+ The prototypes relationship of an instancer can't be time sampled, so the
+ prototype roots and the prims added for each instance are resolved once and
+ shared by every instance, and by every frame when a cache is kept.
+
+ The prototype prims are converted once into templates that are copied for
+ every instance. A template is kept for the following frames as long as
+ nothing it was converted from is animated.
+ */
+
+#ifndef USD_INSTANCER_PROTOTYPES_H
+#define USD_INSTANCER_PROTOTYPES_H
+
+#include <DDImage/Primitive.h>
+#include <DDImage/Vector3.h>
+#include <UsdConverter/UsdAttrConverter.h>
+
+// Standard includes
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Library includes
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/usd/prim.h>
+#include <pxr/usd/usdGeom/pointInstancer.h>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /// Hash of the keys of per-prototype data, a prim path paired with an index or another path
+    struct PathPairHash
+    {
+      size_t operator()(const std::pair<PXR_NS::SdfPath, size_t>& key) const
+      {
+        return Combine(PXR_NS::SdfPath::Hash()(key.first),
+                       std::hash<size_t>()(key.second));
+      }
+
+      size_t operator()(
+          const std::pair<PXR_NS::SdfPath, PXR_NS::SdfPath>& key) const
+      {
+        return Combine(PXR_NS::SdfPath::Hash()(key.first),
+                       PXR_NS::SdfPath::Hash()(key.second));
+      }
+
+     private:
+      static size_t Combine(size_t seed, size_t value)
+      {
+        return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+      }
+    };
+
+    /// The resolved prototypes of a point instancer, indexed by prototype index
+    struct InstancerPrototypes
+    {
+      /// Forwarded targets of the prototypes relationship
+      PXR_NS::SdfPathVector paths;
+      /*! Prims added for each instance of a prototype, the root or else those of
+       * its descendants that can be converted. Empty if the root doesn't exist.
+       */
+      std::vector<std::vector<PXR_NS::UsdPrim>> prims;
+    };
+
+    /// A prototype prim converted once, then added for every instance of it
+    struct PrototypeTemplate
+    {
+      std::vector<DD::Image::Vector3> points;
+      std::unique_ptr<DD::Image::Primitive> primitive;
+      /// Particles are drawn without a material
+      bool clearMaterial = false;
+      std::vector<ConvertedAttribute> attributes;
+      /// Transform of the instances when the instancer doesn't provide one
+      PXR_NS::GfMatrix4d local{1.0};
+      /// Anything it was converted from is animated, so it is converted again every frame
+      bool animated = false;
+    };
+
+    /*! Fingerprint what a prototype prim is converted from, which tells the
+     * templates of different prims and instance attributes apart
+     * \param prim                Prototype prim
+     * \param instanceAttributes  Attributes the prototype is converted with
+     * \return The fingerprint
+     */
+    size_t PrototypeFingerprint(
+        const PXR_NS::UsdPrim& prim,
+        const std::vector<PXR_NS::UsdAttribute>& instanceAttributes);
+
+    /*! Check whether anything a prototype prim is converted from is animated.
+     * This doesn't change with the time, so it is only checked when a template
+     * is first converted.
+     * \param prim                Prototype prim
+     * \param instanceAttributes  Attributes the prototype is converted with
+     * \return True if any of the attributes might be time varying
+     */
+    bool PrototypeAnimated(
+        const PXR_NS::UsdPrim& prim,
+        const std::vector<PXR_NS::UsdAttribute>& instanceAttributes);
+
+    /*! Resolve the prototypes of a point instancer
+     * \param instancer  Instancer to resolve
+     * \param prototypes Output prototypes
+     */
+    void ReadInstancerPrototypes(const PXR_NS::UsdGeomPointInstancer& instancer,
+                                 InstancerPrototypes* prototypes);
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
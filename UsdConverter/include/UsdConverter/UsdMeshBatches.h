@@ -0,0 +1,116 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Header file for merging small meshes into shared Nuke objects
+
+ Scenes dressed with thousands of small meshes spend most of their time on
+ the per-object overhead of Nuke. Meshes below a size threshold whose
+ attributes convert to the same layout are merged into larger objects, one
+ primitive per mesh, with the world transforms baked into the points.
+ */
+
+#ifndef USD_MESH_BATCHES_H
+#define USD_MESH_BATCHES_H
+
+#include <UsdConverter/UsdAttrConverter.h>
+
+// Standard includes
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Library includes
+#include <DDImage/Vector3.h>
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/usdGeom/mesh.h>
+
+namespace DD
+{
+  namespace Image
+  {
+    class GeometryList;
+  }  // namespace Image
+}  // namespace DD
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    struct ConversionContext;
+
+    /// Small meshes collected during a load, added to the geometry as merged objects at the end
+    class MeshBatches
+    {
+     public:
+      /*! \param maxMeshFaces    Meshes with more faces than this aren't merged
+       *  \param maxBatchFaces   Faces at which a merged object is full and a new one is started
+       */
+      MeshBatches(size_t maxMeshFaces, size_t maxBatchFaces);
+
+      /*! Convert a mesh into a batch if it is small enough and its attributes can be merged
+       * \param fromPrim  Mesh to convert
+       * \param world     World transform baked into the mesh
+       * \param ctx       State shared by the converters of the load
+       * \return False if the mesh wasn't taken and has to be converted on its own
+       */
+      bool add(const PXR_NS::UsdGeomMesh& fromPrim,
+               const PXR_NS::GfMatrix4d& world, const ConversionContext& ctx);
+
+      /*! Add an object for each batch, with a name attribute per primitive holding
+       * the path of the mesh it came from
+       * \param out       Geometry output list
+       */
+      void addObjects(DD::Image::GeometryList& out) const;
+
+     private:
+      struct Mesh
+      {
+        std::string path;
+        PXR_NS::VtIntArray faceVertexCounts;
+        PXR_NS::VtIntArray faceVertexIndices;
+        bool leftHanded = false;
+        /// Points in world space
+        std::vector<DD::Image::Vector3> points;
+        /// Converted attributes, in the order of the batch's layout
+        std::vector<ConvertedAttribute> attributes;
+      };
+
+      struct Batch
+      {
+        std::vector<Mesh> meshes;
+        size_t faces = 0;
+      };
+
+      size_t _maxMeshFaces;
+      size_t _maxBatchFaces;
+      std::vector<Batch> _batches;
+      /// Batch still being filled for each attribute layout
+      std::unordered_map<std::string, size_t> _openBatches;
+    };
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
@@ -0,0 +1,75 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Header file for splitting large meshes into spatially coherent chunks
+
+ Nuke processes the objects of a GeometryList in parallel and rebuilds whole
+ objects, so a single mesh with millions of faces is handled on one thread.
+ Splitting it into chunks of neighbouring faces lets each chunk be its own
+ object.
+ */
+
+#ifndef USD_MESH_CHUNKS_H
+#define USD_MESH_CHUNKS_H
+
+// Standard includes
+#include <vector>
+
+// Library includes
+#include <pxr/base/vt/types.h>
+#include <pxr/pxr.h>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /// Topology of one chunk of a split mesh, with the source elements it was made from
+    struct MeshChunk
+    {
+      /// Source point of each chunk point, in ascending order
+      std::vector<unsigned> points;
+      /// Source face vertex of each chunk vertex, in ascending order
+      std::vector<unsigned> vertices;
+      std::vector<int> faceVertexCounts;
+      /// Face vertex indices into the chunk points
+      std::vector<int> faceVertexIndices;
+    };
+
+    /*! Split a mesh into chunks of neighbouring faces, by recursively halving the
+     * faces along the longest axis of their centroids' bounds
+     * \param faceVertexCounts   Vertex count of each face
+     * \param faceVertexIndices  Point index of each face vertex
+     * \param points             Point positions as x, y, z floats
+     * \param pointCount         Number of points
+     * \param maxFaces           Maximum number of faces per chunk
+     * \return The chunks, empty if the mesh doesn't need splitting or its topology is invalid
+     */
+    std::vector<MeshChunk> SplitMesh(const PXR_NS::VtIntArray& faceVertexCounts,
+                                     const PXR_NS::VtIntArray& faceVertexIndices,
+                                     const float* points, size_t pointCount,
+                                     size_t maxFaces);
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
@@ -0,0 +1,156 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Header file for UsdConverter sub-frame sampling of point based prims
+
+ Motion blur evaluates the geometry at several sub-frame times. Instead of
+ resolving the points at every one of them, the authored sample at or before
+ the requested time is read once and the points are extrapolated with the
+ authored velocities and accelerations, following the rules of
+ UsdGeomPointBased::ComputePointsAtTime.
+
+ Without velocities the two authored samples bracketing the requested time are
+ kept in memory and blended directly, so stepping through sub-frames or
+ consecutive frames doesn't read the same samples from the stage again.
+ */
+
+#ifndef USD_MOTION_SAMPLES_H
+#define USD_MOTION_SAMPLES_H
+
+// Library includes
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/timeCode.h>
+#include <pxr/usd/usdGeom/pointBased.h>
+#include <pxr/usd/usdGeom/pointInstancer.h>
+
+// Standard includes
+#include <vector>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    /// Authored point sample with the velocities and accelerations needed to extrapolate it
+    struct PointSamples
+    {
+      /// Time of the authored sample
+      double time = 0.0;
+      /// Time codes per second of the stage, velocities are per second
+      double timeCodesPerSecond = 24.0;
+      PXR_NS::VtVec3fArray points;
+      PXR_NS::VtVec3fArray velocities;
+      /// Optional, empty if not authored
+      PXR_NS::VtVec3fArray accelerations;
+    };
+
+    /*! Read the point sample that the points at a sub-frame time are extrapolated from
+     * \param fromPrim  Point based prim to read
+     * \param time      Requested sub-frame time
+     * \param samples   Output sample data
+     * \return False if the points can't be extrapolated at this time, for example
+     *         when no velocities are authored or the time is on an authored sample
+     */
+    bool ReadPointSamples(const PXR_NS::UsdGeomPointBased& fromPrim,
+                          PXR_NS::UsdTimeCode time, PointSamples* samples);
+
+    /*! Extrapolate points by p + v * dt + 0.5 * a * dt^2
+     * \param samples   The authored sample to extrapolate from
+     * \param time      Time to extrapolate to
+     * \param out       Output x, y, z floats, space for 3 * samples.points.size() floats
+     */
+    void ExtrapolatePoints(const PointSamples& samples, double time, float* out);
+
+    /// The two authored point samples bracketing a time
+    struct BracketingSamples
+    {
+      double lowerTime = 0.0;
+      double upperTime = 0.0;
+      /// Stage interpolation is held, only the lower sample is read
+      bool held = false;
+      PXR_NS::VtVec3fArray lower;
+      PXR_NS::VtVec3fArray upper;
+    };
+
+    /*! Read the authored point samples bracketing a time
+     * \param fromPrim  Point based prim to read
+     * \param time      Requested time
+     * \param previous  Samples read for an earlier time, whose arrays are shared
+     *                  instead of read again when the sample times match. May be null.
+     * \param samples   Output sample data
+     * \return False if the points don't need interpolating at this time, for example
+     *         when they are static or the time is on an authored sample
+     */
+    bool ReadBracketingSamples(const PXR_NS::UsdGeomPointBased& fromPrim,
+                               PXR_NS::UsdTimeCode time,
+                               const BracketingSamples* previous,
+                               BracketingSamples* samples);
+
+    /*! Linearly interpolate between bracketing samples. Samples with different
+     * point counts can't be blended and the lower one is held, as USD does.
+     * \param samples   The bracketing samples
+     * \param time      Time to interpolate to
+     * \param out       Output x, y, z floats, space for 3 * samples.lower.size() floats
+     * \return The number of points written
+     */
+    size_t InterpolatePoints(const BracketingSamples& samples, double time,
+                             float* out);
+
+    /*! Get the times motion blur samples a frame at, evenly spread over a shutter
+     * centred on the frame
+     * \param time      Requested time, the frame is the nearest whole time code
+     * \param samples   Number of samples
+     * \param shutter   Length of the shutter in time codes
+     * \return The sample times, in increasing order
+     */
+    std::vector<double> ShutterTimes(double time, size_t samples, double shutter);
+
+    /// Instance transforms of a point instancer at all the shutter times of a frame
+    struct InstanceTransformSamples
+    {
+      std::vector<double> times;
+      /// Transforms of every instance, one array per time
+      std::vector<PXR_NS::VtMatrix4dArray> transforms;
+
+      /*! Find the transforms at a time
+       * \return The transforms, null if the time isn't one of the samples
+       */
+      const PXR_NS::VtMatrix4dArray* find(double time) const;
+    };
+
+    /*! Compute the instance transforms of a point instancer at several times in one
+     * call, reading the positions, orientations and scales only once. Masked
+     * instances aren't skipped, so the transforms line up with the instance indices.
+     * \param instancer Point instancer
+     * \param times     Times to compute the transforms at
+     * \param samples   Output transforms
+     * \return False if the transforms couldn't be computed
+     */
+    bool ReadInstanceTransformSamples(
+        const PXR_NS::UsdGeomPointInstancer& instancer,
+        const std::vector<double>& times, InstanceTransformSamples* samples);
+  }  // namespace UsdConverter
+}  // namespace Foundry
+
+#endif
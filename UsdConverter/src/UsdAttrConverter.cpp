@@ -25,6 +25,9 @@
  */
 
 #include "UsdConverter/UsdAttrConverter.h"
+#include "UsdConverter/UsdConversionContext.h"
+#include "UsdConverter/UsdHalfFloats.h"
+#include "UsdConverter/UsdMotionSamples.h"
 
 #include <boost/preprocessor/seq/for_each.hpp>
 #include <DDImage/Attribute.h>
@@ -33,6 +36,7 @@
 #include <pxr/base/gf/matrix3f.h>
 #include <pxr/base/gf/matrix4f.h>
 #include <pxr/base/vt/types.h>
+#include <pxr/base/work/loops.h>
 #include <pxr/usd/sdf/types.h>
 #include <pxr/usd/usd/attribute.h>
 #include <pxr/usd/usd/prim.h>
@@ -42,6 +46,7 @@
 #include <pxr/usd/usdGeom/primvarsAPI.h>
 #include <pxr/usd/usdGeom/tokens.h>
 
+#include <algorithm>
 #include <unordered_map>
 
 using namespace DD::Image;
@@ -138,11 +143,105 @@ namespace Foundry
                           {SdfValueTypeNames->Float4, VECTOR4_ATTRIB},
                           {SdfValueTypeNames->Double4, VECTOR4_ATTRIB}};
 
+    AttributeQueries::AttributeQueries(const UsdAttribute& attr) : values(attr)
+    {
+      if(UsdGeomPrimvar::IsPrimvar(attr)) {
+        const UsdGeomPrimvar primvar(attr);
+        if(primvar.IsIndexed()) {
+          indices = UsdAttributeQuery(primvar.GetIndicesAttr());
+        }
+        elementSize = primvar.GetElementSize();
+      }
+    }
+
+    namespace
+    {
+      /// An attribute to read, with its queries if the load's cache keeps them
+      struct AttributeSource
+      {
+        AttributeSource(const UsdAttribute& attr,
+                        const AttributeQueries* queries = nullptr)
+            : attr(attr), queries(queries)
+        {
+        }
+
+        const UsdAttribute& attr;
+        const AttributeQueries* queries;
+
+        bool hasValue() const
+        {
+          return queries ? queries->values.HasValue() : attr.HasValue();
+        }
+
+        /// Number of values per element, which each index selects together
+        int elementSize() const
+        {
+          return queries ? queries->elementSize
+                         : UsdGeomPrimvar(attr).GetElementSize();
+        }
+      };
+
+      /// Get the queries of an attribute from a cache, null without one
+      std::shared_ptr<const AttributeQueries> FindQueries(
+          ConversionCache* cache, const UsdAttribute& attr)
+      {
+        return cache ? cache->attributeQueries(attr) : nullptr;
+      }
+
+      /// Read an array through the queries, flattening it if it is indexed
+      template <class T>
+      bool _GetQueried(VtArray<T>& v, const AttributeQueries& queries,
+                       UsdTimeCode time)
+      {
+        if(!queries.indices.IsValid()) {
+          return queries.values.Get(&v, time);
+        }
+        VtArray<T> values;
+        VtIntArray indices;
+        if(!queries.values.Get(&values, time)) {
+          return false;
+        }
+        // Like a primvar that can't be flattened, fall back to the raw values
+        v = values;
+        if(!queries.indices.Get(&indices, time)) {
+          return true;
+        }
+        // Each index selects elementSize consecutive values
+        const size_t elementSize =
+            static_cast<size_t>(std::max(queries.elementSize, 1));
+        VtArray<T> flattened(indices.size() * elementSize);
+        T* toValue = flattened.data();
+        for(const int index : indices) {
+          if(index < 0 ||
+             (static_cast<size_t>(index) + 1) * elementSize > values.size()) {
+            return true;
+          }
+          toValue = std::copy_n(values.cdata() + index * elementSize,
+                                elementSize, toValue);
+        }
+        v = std::move(flattened);
+        return true;
+      }
+
+      template <class DEST>
+      bool _GetQueried(DEST& v, const AttributeQueries& queries,
+                       UsdTimeCode time)
+      {
+        return queries.values.Get(&v, time);
+      }
+    }  // namespace
+
     /// Get attr value at time. Template expression enables this function for types that attributes can hold
     template <class DEST,
               std::enable_if_t<SdfValueTypeTraits<DEST>::IsValueType, int> = 0>
-    bool _ComputePrimvar(DEST& v, const UsdAttribute& attr, UsdTimeCode time)
+    bool _ComputePrimvar(DEST& v, const AttributeSource& source,
+                         UsdTimeCode time)
     {
+      // The queries already know whether the values are indexed
+      if(source.queries) {
+        return _GetQueried(v, *source.queries, time);
+      }
+      const UsdAttribute& attr = source.attr;
       bool result = false;
       // Compute the value at the requested time
       if(UsdGeomPrimvar::IsPrimvar(attr)) {
@@ -158,7 +257,7 @@ namespace Foundry
     template <
         class DEST,
         std::enable_if_t<!(SdfValueTypeTraits<DEST>::IsValueType), int> = 0>
-    bool _ComputePrimvar(DEST&, const UsdAttribute&, UsdTimeCode)
+    bool _ComputePrimvar(DEST&, const AttributeSource&, UsdTimeCode)
     {
       return false;
     };
@@ -171,11 +270,13 @@ namespace Foundry
         std::enable_if_t<GfIsGfVec<typename DEST::value_type>::value, int> = 0>
     void _CopyToVt(DEST& destination, const SOURCE& source)
     {
+      // Extra source components are dropped, missing ones are left at zero
+      const size_t dimension = std::min<size_t>(SOURCE::value_type::dimension,
+                                                DEST::value_type::dimension);
       destination.resize(source.size());
       auto destination_it = destination.begin();
       for(const typename SOURCE::value_type& elem : source) {
-        std::copy(elem.data(), elem.data() + elem.dimension,
-                  destination_it->data());
+        std::copy(elem.data(), elem.data() + dimension, destination_it->data());
         ++destination_it;
       }
     }
@@ -225,42 +326,179 @@ namespace Foundry
     {
     }
 
+    /// Whether values of SOURCE can be copied into DEST. Matrices need the same shape.
     template <class DEST, class SOURCE>
-    void _Convert(DEST& value, const UsdAttribute& attr, UsdTimeCode time)
+    struct _IsConvertible
     {
-      if(!attr.GetTypeName().GetType().IsA<SOURCE>()) {
-        return;
+      using S = typename SOURCE::value_type;
+      using D = typename DEST::value_type;
+      static constexpr bool value =
+          GfIsGfVec<S>::value == GfIsGfVec<D>::value &&
+          GfIsGfMatrix<S>::value == GfIsGfMatrix<D>::value;
+    };
+
+    template <class DEST, class SOURCE>
+    struct _IsSameMatrixShape
+    {
+      using S = typename SOURCE::value_type;
+      using D = typename DEST::value_type;
+      static constexpr bool value =
+          S::numRows == D::numRows && S::numColumns == D::numColumns;
+    };
+
+    /// Whether SOURCE holds halves that decode into the floats of DEST, with the same layout
+    template <class DEST, class SOURCE>
+    struct _IsHalfDecodable : std::false_type
+    {
+    };
+    template <>
+    struct _IsHalfDecodable<VtFloatArray, VtHalfArray> : std::true_type
+    {
+    };
+    template <>
+    struct _IsHalfDecodable<VtVec2fArray, VtVec2hArray> : std::true_type
+    {
+    };
+    template <>
+    struct _IsHalfDecodable<VtVec3fArray, VtVec3hArray> : std::true_type
+    {
+    };
+    template <>
+    struct _IsHalfDecodable<VtVec4fArray, VtVec4hArray> : std::true_type
+    {
+    };
+
+    // Halves -> floats, decoded as one flat array of components
+    template <class DEST, class SOURCE>
+    void _CopyInto(DEST& destination, const SOURCE& source, std::true_type)
+    {
+      destination.resize(source.size());
+      if(!source.empty()) {
+        DecodeHalfs(reinterpret_cast<const GfHalf*>(source.cdata()),
+                    source.size() * sizeof(typename SOURCE::value_type) /
+                        sizeof(GfHalf),
+                    reinterpret_cast<float*>(destination.data()));
       }
+    }
+
+    template <class DEST, class SOURCE>
+    void _CopyInto(DEST& destination, const SOURCE& source, std::false_type)
+    {
+      _CopyToVt<DEST, SOURCE>(destination, source);
+    }
 
+    template <class DEST, class SOURCE>
+    void _Convert(DEST& value, const AttributeSource& source, UsdTimeCode time)
+    {
       SOURCE converted;
-      _ComputePrimvar(converted, attr, time);
-      _CopyToVt<DEST, SOURCE>(value, converted);
+      _ComputePrimvar(converted, source, time);
+      _CopyInto(value, converted, _IsHalfDecodable<DEST, SOURCE>());
     }
 
+    /// The value types that can be converted into DEST, each with its converter, built once
     template <class DEST>
-    void ComputePrimvar(DEST& value, const UsdAttribute& attr, UsdTimeCode time)
+    class PrimvarConversions
     {
-      if(attr.GetTypeName().GetType().IsA<DEST>()) {
-        _ComputePrimvar(value, attr, time);
-        return;
+     public:
+      using Converter = void (*)(DEST&, const AttributeSource&, UsdTimeCode);
+
+      static const PrimvarConversions& get()
+      {
+        static const PrimvarConversions conversions;
+        return conversions;
+      }
+
+      /// Get the converter from a value type, null if it can't be converted
+      Converter find(const TfType& source) const
+      {
+        const auto it = _converters.find(source);
+        return it == _converters.cend() ? nullptr : it->second;
       }
 
-      // The wrong type was requested, find the right type and then copy it.
-      // If the types aren't matching correctly, such as a mismatch between float and double types,
-      // then this series of template calls will try and match and fill the VtArray type with the data from the attribute.
+     private:
+      PrimvarConversions()
+      {
 #define VT_ARRAY_NAME(elem) BOOST_PP_TUPLE_ELEM(2, 0, elem)
-#define TRY_CONVERT(r, unused, elem) \
-  _Convert<DEST, VtArray<VT_ARRAY_NAME(elem)>>(value, attr, time);
-      BOOST_PP_SEQ_FOR_EACH(TRY_CONVERT, ~, VT_VEC_VALUE_TYPES)
-      BOOST_PP_SEQ_FOR_EACH(TRY_CONVERT, ~, VT_MATRIX_VALUE_TYPES)
-      BOOST_PP_SEQ_FOR_EACH(TRY_CONVERT, ~, VT_BUILTIN_NUMERIC_VALUE_TYPES)
-#undef TRY_CONVERT
+#define ADD_CONVERSION(r, unused, elem) add<VtArray<VT_ARRAY_NAME(elem)>>();
+        BOOST_PP_SEQ_FOR_EACH(ADD_CONVERSION, ~, VT_VEC_VALUE_TYPES)
+        BOOST_PP_SEQ_FOR_EACH(ADD_CONVERSION, ~, VT_MATRIX_VALUE_TYPES)
+        BOOST_PP_SEQ_FOR_EACH(ADD_CONVERSION, ~, VT_BUILTIN_NUMERIC_VALUE_TYPES)
+#undef ADD_CONVERSION
+      }
+
+      template <class SOURCE,
+                std::enable_if_t<_IsConvertible<DEST, SOURCE>::value &&
+                                     !GfIsGfMatrix<typename SOURCE::value_type>::value,
+                                 int> = 0>
+      void add()
+      {
+        _converters.emplace(TfType::Find<SOURCE>(), &_Convert<DEST, SOURCE>);
+      }
+
+      template <class SOURCE,
+                std::enable_if_t<GfIsGfMatrix<typename SOURCE::value_type>::value &&
+                                     GfIsGfMatrix<typename DEST::value_type>::value,
+                                 int> = 0>
+      void add()
+      {
+        if(_IsSameMatrixShape<DEST, SOURCE>::value) {
+          _converters.emplace(TfType::Find<SOURCE>(), &_Convert<DEST, SOURCE>);
+        }
+      }
+
+      // Mismatch - not convertible
+      template <class SOURCE,
+                std::enable_if_t<!_IsConvertible<DEST, SOURCE>::value, int> = 0>
+      void add()
+      {
+      }
+
+      struct TypeHash
+      {
+        size_t operator()(const TfType& type) const { return hash_value(type); }
+      };
+
+      std::unordered_map<TfType, Converter, TypeHash> _converters;
+    };
+
+    /// Compute attribute through its queries if it has them, converting it into DEST
+    template <class DEST>
+    void _ComputeConverted(DEST& value, const AttributeSource& source,
+                           UsdTimeCode time)
+    {
+      const TfType type = source.attr.GetTypeName().GetType();
+      if(type.IsA<DEST>()) {
+        _ComputePrimvar(value, source, time);
+        return;
+      }
+
+      // The wrong type was requested, such as a mismatch between float and
+      // double types. Look up the converter that reads the attribute's type and
+      // copies it into the requested type.
+      const auto convert = PrimvarConversions<DEST>::get().find(type);
+      if(convert) {
+        convert(value, source, time);
+      }
+    }
+
+    template <class DEST>
+    void ComputePrimvar(DEST& value, const UsdAttribute& attr, UsdTimeCode time)
+    {
+      _ComputeConverted(value, AttributeSource(attr), time);
+    }
+
+    template <class DEST>
+    bool CanComputePrimvar(const TfType& source)
+    {
+      return source.IsA<DEST>() ||
+             PrimvarConversions<DEST>::get().find(source) != nullptr;
     }
 
 // Generate templates
-#define DECLARE_COMPUTE_PRIMVAR(r, unused, elem)              \
-  template void ComputePrimvar<VtArray<VT_ARRAY_NAME(elem)>>( \
-      VtArray<VT_ARRAY_NAME(elem)>&, const UsdAttribute&, UsdTimeCode);
+#define DECLARE_COMPUTE_PRIMVAR(r, unused, elem)                         \
+  template void ComputePrimvar<VtArray<VT_ARRAY_NAME(elem)>>(            \
+      VtArray<VT_ARRAY_NAME(elem)>&, const UsdAttribute&, UsdTimeCode); \
+  template bool CanComputePrimvar<VtArray<VT_ARRAY_NAME(elem)>>(const TfType&);
     BOOST_PP_SEQ_FOR_EACH(DECLARE_COMPUTE_PRIMVAR, ~, VT_VEC_VALUE_TYPES)
     BOOST_PP_SEQ_FOR_EACH(DECLARE_COMPUTE_PRIMVAR, ~, VT_MATRIX_VALUE_TYPES)
     BOOST_PP_SEQ_FOR_EACH(DECLARE_COMPUTE_PRIMVAR, ~,
@@ -286,29 +524,27 @@ namespace Foundry
     template VtVec3fArray GetOffsetArray<VtVec3fArray>(const VtVec3fArray&, int,
                                                        int);
 
-    ColorUvData::ColorUvData(const ColorUvData& other, int offset)
+    ColorUvSpans::ColorUvSpans(const ColorUvData& data)
+        : uvs(data.uvs),
+          color(data.color),
+          opacity(data.opacity),
+          faceVertexIndices(data.faceVertexIndices),
+          uvIndices(data.uvIndices),
+          uvGroup(data.uvGroup),
+          colorGroup(data.colorGroup),
+          opacityGroup(data.opacityGroup)
     {
-      uvs = GetOffsetArray(other.uvs, offset, other.uvElementSize);
+    }
 
-      if(other.color.size() >
-         static_cast<size_t>((offset + 1) * other.colorElementSize)) {
-        color.assign(
-            other.color.begin() + offset * other.colorElementSize,
-            other.color.begin() + (offset + 1) * other.colorElementSize);
-      }
-      if(other.opacity.size() >
-         static_cast<size_t>((offset + 1) * other.opacityElementSize)) {
-        opacity.assign(
-            other.opacity.begin() + offset * other.opacityElementSize,
-            other.opacity.begin() + (offset + 1) * other.opacityElementSize);
-      }
-      faceVertexIndices = other.faceVertexIndices;
-      uvElementSize = other.uvElementSize;
-      colorElementSize = other.colorElementSize;
-      opacityElementSize = other.opacityElementSize;
-      uvGroup = other.uvGroup;
-      colorGroup = other.colorGroup;
-      opacityGroup = other.opacityGroup;
+    ColorUvSpans::ColorUvSpans(const ColorUvData& data, size_t offset)
+        : uvs(data.uvs, offset, data.uvElementSize),
+          color(data.color, offset, data.colorElementSize),
+          opacity(data.opacity, offset, data.opacityElementSize),
+          faceVertexIndices(data.faceVertexIndices),
+          uvGroup(data.uvGroup),
+          colorGroup(data.colorGroup),
+          opacityGroup(data.opacityGroup)
+    {
     }
 
     static const std::vector<GroupType> groupTypeOrder{
@@ -323,7 +559,7 @@ namespace Foundry
     };
 
     size_t PromoteAttribute(GroupType target, GroupType source,
-                            const VtUIntArray& faceVertexIndices,
+                            ArraySpan<unsigned int> faceVertexIndices,
                             size_t index)
     {
       const auto start = ordering(target);
@@ -357,36 +593,150 @@ namespace Foundry
       const VtFloatArray kDefaultOpacityValues{1.0f};
     }  // namespace
 
-    void ConvertColor(Attribute& Cf, const VtArray<GfVec3f>& color,
-                      GroupType colorGroup, const VtFloatArray& opacity,
+    namespace
+    {
+      /// How PromoteAttribute maps every index of one group into a less granular one
+      enum class Promotion
+      {
+        /// Same group, each element has its own value
+        Same,
+        /// Vertices take the value of their point, through the face vertex indices
+        PointOfVertex,
+        /// Every element takes the first value
+        First
+      };
+
+      /// Work out once what PromoteAttribute would do for every index
+      Promotion FindPromotion(GroupType target, GroupType source)
+      {
+        const auto start = ordering(target);
+        const auto end = ordering(source);
+        if(target == Group_Points && source == Group_Vertices) {
+          return Promotion::PointOfVertex;
+        }
+        // Stepping down through the points or primitives level lands on the one Nuke primitive
+        const auto points = ordering(Group_Points);
+        const auto primitives = ordering(Group_Primitives);
+        if(start < end && start < points && end >= primitives) {
+          return Promotion::First;
+        }
+        return Promotion::Same;
+      }
+
+      // Index functors for each promotion, clamped to the last value like ConvertColor always did
+      struct SameIndex
+      {
+        size_t last;
+        size_t operator()(size_t i) const { return std::min(i, last); }
+      };
+
+      struct PointOfVertexIndex
+      {
+        ArraySpan<unsigned int> faceVertexIndices;
+        size_t last;
+        size_t operator()(size_t i) const
+        {
+          const size_t point =
+              i < faceVertexIndices.size() ? faceVertexIndices[i] : i;
+          return std::min(point, last);
+        }
+      };
+
+      struct FirstIndex
+      {
+        size_t operator()(size_t) const { return 0; }
+      };
+
+      /// Call fn with the index functor of a promotion into size values
+      template <class FN>
+      void WithPromotion(Promotion promotion,
+                         ArraySpan<unsigned int> faceVertexIndices, size_t size,
+                         FN&& fn)
+      {
+        switch(promotion) {
+          case Promotion::PointOfVertex:
+            fn(PointOfVertexIndex{faceVertexIndices, size - 1});
+            break;
+          case Promotion::First:
+            fn(FirstIndex());
+            break;
+          default:
+            fn(SameIndex{size - 1});
+            break;
+        }
+      }
+
+      /// Arrays with fewer elements than this are not worth splitting across threads
+      const size_t kParallelElements = 1 << 16;
+
+      /// Call fn(begin, end) over [0, n), in parallel chunks for large arrays
+      template <class FN>
+      void ForEachChunk(size_t n, FN&& fn)
+      {
+        if(n < kParallelElements) {
+          fn(size_t(0), n);
+        }
+        else {
+          WorkParallelForN(n, fn);
+        }
+      }
+    }  // namespace
+
+    void ConvertColor(Attribute& Cf, ArraySpan<GfVec3f> color,
+                      GroupType colorGroup, ArraySpan<float> opacity,
                       GroupType opacityGroup,
-                      const VtUIntArray& faceVertexIndices)
+                      ArraySpan<unsigned int> faceVertexIndices)
     {
       GroupType maxGroup = groupTypeOrder[std::max(ordering(colorGroup),
                                                    ordering(opacityGroup))];
 
       auto size = std::max(color.size(), opacity.size());
       Cf.resize(size);
-      for(size_t i = 0; i < size; ++i) {
-        Vector4& c = Cf.vector4(i);
-        auto colorIndex = std::min(
-            PromoteAttribute(colorGroup, maxGroup, faceVertexIndices, i),
-            color.size() - 1);
-        // There can be a mismatch between the GroupType (Nuke) and USD interpolation for color and opacity, as they're stored in USD as separate
-        // attributes. For example, if the color is provided in USD as faceVarying (equivalent to Nuke vertex) but the opacity is constant in USD
-        // (equivalent to Nuke object level). Since vertex is a finer level of detail than object, the data would be stored per vertex in Nuke,
-        // but the object level opacity would be copied multiple times.
-        auto opacityIndex = std::min(
-            PromoteAttribute(opacityGroup, maxGroup, faceVertexIndices, i),
-            opacity.size() - 1);
-        c[0] = color[colorIndex][0];
-        c[1] = color[colorIndex][1];
-        c[2] = color[colorIndex][2];
-        c[3] = opacity[opacityIndex];
-      }
-    }
-
-    void ConvertUvs(Attribute& toAttr, const VtVec2fArray& uvs)
+      if(size == 0) {
+        return;
+      }
+      Vector4* out = &Cf.vector4(0);
+
+      // There can be a mismatch between the GroupType (Nuke) and USD interpolation for color and opacity, as they're stored in USD as separate
+      // attributes. For example, if the color is provided in USD as faceVarying (equivalent to Nuke vertex) but the opacity is constant in USD
+      // (equivalent to Nuke object level). Since vertex is a finer level of detail than object, the data would be stored per vertex in Nuke,
+      // but the object level opacity would be copied multiple times.
+      // The promotions are worked out once instead of for every element.
+      const Promotion colorPromotion = FindPromotion(colorGroup, maxGroup);
+      const Promotion opacityPromotion = FindPromotion(opacityGroup, maxGroup);
+
+      if(colorPromotion == Promotion::Same &&
+         opacityPromotion == Promotion::Same && color.size() == size &&
+         opacity.size() == size) {
+        // Straight interleave of the color and opacity
+        const GfVec3f* fromColor = color.begin();
+        const float* fromOpacity = opacity.begin();
+        ForEachChunk(size, [&](size_t begin, size_t end) {
+          for(size_t i = begin; i < end; ++i) {
+            out[i].set(fromColor[i][0], fromColor[i][1], fromColor[i][2],
+                       fromOpacity[i]);
+          }
+        });
+        return;
+      }
+
+      WithPromotion(
+          colorPromotion, faceVertexIndices, color.size(),
+          [&](auto colorIndex) {
+            WithPromotion(
+                opacityPromotion, faceVertexIndices, opacity.size(),
+                [&](auto opacityIndex) {
+                  ForEachChunk(size, [&](size_t begin, size_t end) {
+                    for(size_t i = begin; i < end; ++i) {
+                      const GfVec3f& c = color[colorIndex(i)];
+                      out[i].set(c[0], c[1], c[2], opacity[opacityIndex(i)]);
+                    }
+                  });
+                });
+          });
+    }
+
+    void ConvertUvs(Attribute& toAttr, ArraySpan<GfVec2f> uvs)
     {
       toAttr.clear();
       toAttr.reserve(uvs.size());
@@ -396,6 +746,77 @@ namespace Foundry
       }
     }
 
+    namespace
+    {
+      /*! Flatten indexed values straight into the elements of a Nuke attribute
+       * list, in parallel chunks for large arrays
+       * \param values    Values to gather
+       * \param indices   Index of the value of each element
+       * \param toList    List to fill, resized to one element per index
+       * \param convert   Converts a value into a list element
+       * \param fallback  Element of out of range indices
+       */
+      template <class T, class LIST, class CONVERT>
+      void GatherIndexed(ArraySpan<T> values, ArraySpan<int> indices,
+                         LIST& toList, CONVERT&& convert,
+                         const typename LIST::value_type& fallback)
+      {
+        toList.resize(indices.size());
+        if(indices.empty()) {
+          return;
+        }
+        auto* out = &toList[0];
+        ForEachChunk(indices.size(), [&](size_t begin, size_t end) {
+          for(size_t i = begin; i < end; ++i) {
+            const int index = indices[i];
+            out[i] = index >= 0 && static_cast<size_t>(index) < values.size()
+                         ? convert(values[index])
+                         : fallback;
+          }
+        });
+      }
+    }  // namespace
+
+    void ConvertUvs(Attribute& toAttr, ArraySpan<GfVec2f> uvs,
+                    ArraySpan<int> indices)
+    {
+      toAttr.clear();
+      // Nuke stores UVS as 4 floats to match an OpenGL fixed pipeline call later.
+      GatherIndexed(
+          uvs, indices, *toAttr.vector4_list,
+          [](const GfVec2f& uv) { return Vector4(uv[0], uv[1], 0.0f, 1.0f); },
+          Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+
+    bool FindPointIndices(ArraySpan<GfVec2f> values,
+                          ArraySpan<int> vertexIndices,
+                          ArraySpan<unsigned int> faceVertexIndices,
+                          size_t pointCount, VtIntArray* pointIndices)
+    {
+      if(vertexIndices.size() != faceVertexIndices.size()) {
+        return false;
+      }
+      pointIndices->assign(pointCount, -1);
+      int* toIndices = pointIndices->data();
+      for(size_t v = 0; v < vertexIndices.size(); ++v) {
+        const size_t point = faceVertexIndices[v];
+        const int index = vertexIndices[v];
+        if(point >= pointCount || index < 0 ||
+           static_cast<size_t>(index) >= values.size()) {
+          return false;
+        }
+        int& pointIndex = toIndices[point];
+        if(pointIndex == -1) {
+          pointIndex = index;
+        }
+        else if(pointIndex != index && values[pointIndex] != values[index]) {
+          // A seam, the point's vertices need different values
+          return false;
+        }
+      }
+      return true;
+    }
+
     bool UvOrdering(const UsdAttribute& a, const UsdAttribute& b)
     {
       if(a.GetName() == usdTokens.st) {
@@ -420,30 +841,230 @@ namespace Foundry
       return points.size();
     }
 
-    void ConvertColorUvs(GeometryList& out, const int obj, const ColorUvData& data)
+    namespace
+    {
+      /*! Compute the points at a sub-frame time from the samples kept in memory,
+       * extrapolated with the velocities or else blended between the bracketing samples
+       * \return False if the points need to be read as usual at this time
+       */
+      template <class POINTS>
+      bool SamplePoints(POINTS& toPoints, const UsdGeomPointBased& fromPrim,
+                        const ConversionContext& ctx)
+      {
+        std::shared_ptr<const PointSamples> samples;
+        if(ctx.cache) {
+          // Sub-frame samples of the same frame share one read of the authored sample
+          samples = ctx.cache->pointSamples(fromPrim, ctx.time);
+        }
+        else {
+          auto read = std::make_shared<PointSamples>();
+          if(ReadPointSamples(fromPrim, ctx.time, read.get())) {
+            samples = read;
+          }
+        }
+        if(samples) {
+          toPoints.resize(samples->points.size());
+          ExtrapolatePoints(*samples, ctx.time.GetValue(),
+                            reinterpret_cast<float*>(toPoints.data()));
+          return true;
+        }
+
+        std::shared_ptr<const BracketingSamples> bracketing;
+        if(ctx.cache) {
+          bracketing = ctx.cache->bracketingSamples(fromPrim, ctx.time);
+        }
+        if(bracketing) {
+          toPoints.resize(bracketing->lower.size());
+          InterpolatePoints(*bracketing, ctx.time.GetValue(),
+                            reinterpret_cast<float*>(toPoints.data()));
+          return true;
+        }
+        return false;
+      }
+    }  // namespace
+
+    size_t ConvertPoints(GeometryList& out, const int obj,
+                         const UsdGeomPointBased& fromPrim,
+                         const ConversionContext& ctx)
     {
-      if(data.uvs.size() > 0) {
-        Attribute* toUv = out.writable_attribute(obj, data.uvGroup, kUVAttrName,
-                                                 VECTOR4_ATTRIB);
-        ConvertUvs(*toUv, data.uvs);
+      PointList* toPoints = out.writable_points(obj);
+      if(SamplePoints(*toPoints, fromPrim, ctx)) {
+        return toPoints->size();
       }
+      return ConvertPoints(out, obj, fromPrim.GetPointsAttr(), ctx.time);
+    }
 
-      GroupType maxGroup = groupTypeOrder[std::max(
-          ordering(data.colorGroup), ordering(data.opacityGroup))];
-      if(maxGroup != Group_None) {  // Neither color or opacity was set
-        Attribute* Cf = out.writable_attribute(
-            obj, maxGroup, nukeTokens.Cf.GetText(), VECTOR4_ATTRIB);
-        ConvertColor(
-            *Cf, data.color.size() > 0 ? data.color : kDefaultColorValues,
-            data.colorGroup,
-            data.opacity.size() > 0 ? data.opacity : kDefaultOpacityValues,
-            data.opacityGroup, data.faceVertexIndices);
+    size_t ConvertPoints(std::vector<Vector3>& toPoints,
+                         const UsdGeomPointBased& fromPrim,
+                         const ConversionContext& ctx)
+    {
+      if(SamplePoints(toPoints, fromPrim, ctx)) {
+        return toPoints.size();
+      }
+      VtVec3fArray points;
+      ComputePrimvar(points, fromPrim.GetPointsAttr(), ctx.time);
+      toPoints.clear();
+      toPoints.reserve(points.size());
+      for(const auto& from : points) {
+        toPoints.emplace_back(from[0], from[1], from[2]);
       }
+      return toPoints.size();
     }
 
+    namespace
+    {
+      // The conversions below create their Nuke attributes through
+      // add(name, group, type), so the same conversion can fill an object of a
+      // geometry list or attributes that aren't part of one yet.
+
+      /*! Add indexed uvs per point when every vertex of a point uses the same uv,
+       * otherwise flattened straight into the Nuke attribute
+       * \param pointCount    Number of points of the object, 0 if not known
+       */
+      template <class ADD>
+      void ConvertIndexedUvsWith(const ColorUvSpans& data, size_t pointCount,
+                                 ADD&& add)
+      {
+        VtIntArray pointIndices;
+        if(data.uvGroup == Group_Vertices && pointCount > 0 &&
+           FindPointIndices(data.uvs, data.uvIndices, data.faceVertexIndices,
+                            pointCount, &pointIndices)) {
+          Attribute* toUv = add(nukeTokens.uv, Group_Points, VECTOR4_ATTRIB);
+          ConvertUvs(*toUv, data.uvs, pointIndices);
+          return;
+        }
+        Attribute* toUv = add(nukeTokens.uv, data.uvGroup, VECTOR4_ATTRIB);
+        ConvertUvs(*toUv, data.uvs, data.uvIndices);
+      }
+
+      template <class ADD>
+      void ConvertColorUvsWith(const ColorUvSpans& data, size_t pointCount,
+                               ADD&& add)
+      {
+        if(!data.uvIndices.empty()) {
+          ConvertIndexedUvsWith(data, pointCount, add);
+        }
+        else if(data.uvs.size() > 0) {
+          Attribute* toUv = add(nukeTokens.uv, data.uvGroup, VECTOR4_ATTRIB);
+          ConvertUvs(*toUv, data.uvs);
+        }
+
+        GroupType maxGroup = groupTypeOrder[std::max(
+            ordering(data.colorGroup), ordering(data.opacityGroup))];
+        if(maxGroup != Group_None) {  // Neither color or opacity was set
+          Attribute* Cf = add(nukeTokens.Cf, maxGroup, VECTOR4_ATTRIB);
+          ConvertColor(*Cf,
+                       data.color.size() > 0
+                           ? data.color
+                           : ArraySpan<GfVec3f>(kDefaultColorValues),
+                       data.colorGroup,
+                       data.opacity.size() > 0
+                           ? data.opacity
+                           : ArraySpan<float>(kDefaultOpacityValues),
+                       data.opacityGroup, data.faceVertexIndices);
+        }
+      }
+
+      template <class ADD>
+      Attribute* ConstructAttributeWith(const AttributeSource& source, ADD&& add)
+      {
+        // Most attributes are rejected by name, before any value is resolved
+        const AttributeTarget target = ResolveAttributeTarget(source.attr);
+        if(!target.convert || !source.hasValue()) {
+          return nullptr;
+        }
+        return add(target.name, target.group, target.type);
+      }
+
+      /// Convert the values of an attribute, through its queries if it has them
+      void ConvertSourceValues(Attribute* toAttr, const AttributeSource& source,
+                               const UsdTimeCode time, int offset, int stride);
+
+      /*! \param pointCount    Number of points of the object, 0 if not known. Indexed
+       *                      uvs are only stored per point when it is known.
+       */
+      template <class ADD>
+      void ConvertUsdAttributesWith(const std::vector<UsdAttribute>& primvars,
+                                    const UsdTimeCode time, size_t pointCount,
+                                    ConversionCache* cache, ADD&& add)
+      {
+        ColorUvData data;
+        // Convert attributes first that don't map to Nuke ones directly, then convert what remains
+        UsdAttributeVector remainingAttributes =
+            ConvertMismatchedAttributes(data, primvars, time, true, cache);
+        ConvertColorUvsWith(data, pointCount, add);
+        for(auto& fromAttr : remainingAttributes) {
+          // Queries are only kept for the attributes with a Nuke counterpart
+          const auto queries = mappedNames.count(fromAttr.GetName()) > 0
+                                   ? FindQueries(cache, fromAttr)
+                                   : nullptr;
+          const AttributeSource source(fromAttr, queries.get());
+          Attribute* toAttr = ConstructAttributeWith(source, add);
+          if(!toAttr) {
+            continue;
+          }
+          ConvertSourceValues(toAttr, source, time, -1, -1);
+        }
+      }
+
+      /// Add attributes to an object of a geometry list
+      auto ObjectAttributes(GeometryList& out, const int obj)
+      {
+        return [&out, obj](const TfToken& name, GroupType group,
+                           AttribType type) {
+          return out.writable_attribute(obj, group, name.GetText(), type);
+        };
+      }
+    }  // namespace
+
+    void ConvertColorUvs(GeometryList& out, const int obj, const ColorUvSpans& data)
+    {
+      ConvertColorUvsWith(data, 0, ObjectAttributes(out, obj));
+    }
+
+    namespace
+    {
+      /*! Read the values and indices of an indexed primvar without flattening them
+       * \return False if the attribute isn't an indexed primvar of the value type
+       *         with one value per index, in which case it has to be flattened
+       */
+      template <class T>
+      bool ComputeIndexedPrimvar(VtArray<T>& values, VtIntArray& indices,
+                                 const AttributeSource& source, UsdTimeCode time)
+      {
+        const UsdAttribute& attr = source.attr;
+        if(!attr.GetTypeName().GetType().IsA<VtArray<T>>()) {
+          return false;
+        }
+        // Each index selects elementSize values, which only flattening expands
+        if(source.elementSize() != 1) {
+          return false;
+        }
+        if(source.queries) {
+          if(!source.queries->indices.IsValid() ||
+             !source.queries->indices.Get(&indices, time) ||
+             !source.queries->values.Get(&values, time)) {
+            indices.clear();
+            return false;
+          }
+          return true;
+        }
+        if(!UsdGeomPrimvar::IsPrimvar(attr)) {
+          return false;
+        }
+        const UsdGeomPrimvar primvar(attr);
+        if(!primvar.IsIndexed() || !primvar.GetIndices(&indices, time) ||
+           !attr.Get(&values, time)) {
+          indices.clear();
+          return false;
+        }
+        return true;
+      }
+    }  // namespace
+
     std::vector<UsdAttribute> ConvertMismatchedAttributes(
         ColorUvData& data, const std::vector<UsdAttribute>& attrs,
-        const UsdTimeCode time)
+        const UsdTimeCode time, bool keepIndexed, ConversionCache* cache)
     {
       std::vector<UsdAttribute> unhandledAttributes;
 
@@ -453,16 +1074,22 @@ namespace Foundry
         }
         else if(fromAttr.GetName() == UsdGeomTokens->primvarsDisplayColor) {
           data.colorGroup = ConvertGroupType(fromAttr);
-          ComputePrimvar(data.color, fromAttr, time);
-          data.colorElementSize = UsdGeomPrimvar(fromAttr).GetElementSize();
+          const auto queries = FindQueries(cache, fromAttr);
+          const AttributeSource source(fromAttr, queries.get());
+          _ComputeConverted(data.color, source, time);
+          data.colorElementSize = source.elementSize();
         }
         else if(fromAttr.GetName() == UsdGeomTokens->primvarsDisplayOpacity) {
           data.opacityGroup = ConvertGroupType(fromAttr);
-          ComputePrimvar(data.opacity, fromAttr, time);
-          data.opacityElementSize = UsdGeomPrimvar(fromAttr).GetElementSize();
+          const auto queries = FindQueries(cache, fromAttr);
+          const AttributeSource source(fromAttr, queries.get());
+          _ComputeConverted(data.opacity, source, time);
+          data.opacityElementSize = source.elementSize();
         }
         else if(fromAttr.GetName() == UsdGeomTokens->faceVertexIndices) {
-          ComputePrimvar(data.faceVertexIndices, fromAttr, time);
+          const auto queries = FindQueries(cache, fromAttr);
+          _ComputeConverted(data.faceVertexIndices,
+                            AttributeSource(fromAttr, queries.get()), time);
         }
         else if(fromAttr.GetName() == usdTokens.st ||
                 (textureTypes.find(fromAttr.GetTypeName().GetScalarType()) !=
@@ -477,12 +1104,38 @@ namespace Foundry
       if(!uvAttrs.empty()) {
         const UsdAttribute& fromUv = *(uvAttrs.begin());
         data.uvGroup = ConvertGroupType(fromUv);
-        ComputePrimvar(data.uvs, fromUv, time);
-        data.uvElementSize = UsdGeomPrimvar(fromUv).GetElementSize();
+        const auto queries = FindQueries(cache, fromUv);
+        const AttributeSource source(fromUv, queries.get());
+        if(!keepIndexed ||
+           !ComputeIndexedPrimvar(data.uvs, data.uvIndices, source, time)) {
+          _ComputeConverted(data.uvs, source, time);
+        }
+        data.uvElementSize = source.elementSize();
       }
       return unhandledAttributes;
     }
 
+    std::vector<UsdAttribute> ConvertibleAttributes(const UsdPrim& prim)
+    {
+      // Builtins that aren't primvars but are converted, or needed to promote colors
+      static const TfTokenVector builtins{
+          UsdGeomTokens->faceVertexIndices, UsdGeomTokens->normals,
+          UsdGeomTokens->velocities, UsdGeomTokens->widths,
+          UsdGeomTokens->pointWeights};
+
+      std::vector<UsdAttribute> attrs;
+      for(const auto& name : builtins) {
+        UsdAttribute attr = prim.GetAttribute(name);
+        if(attr && attr.HasValue()) {
+          attrs.push_back(attr);
+        }
+      }
+      for(const auto& primvar : UsdGeomPrimvarsAPI(prim).GetPrimvarsWithValues()) {
+        attrs.push_back(primvar.GetAttr());
+      }
+      return attrs;
+    }
+
     TfToken ConvertName(const UsdAttribute& fromAttr)
     {
       const auto it_name = mappedNames.find(fromAttr.GetName());
@@ -537,6 +1190,22 @@ namespace Foundry
       }
     }
 
+    AttributeTarget ResolveAttributeTarget(const UsdAttribute& fromAttr)
+    {
+      // Attributes without a Nuke counterpart are rejected by name alone
+      const auto it_name = mappedNames.find(fromAttr.GetName());
+      if(it_name == mappedNames.cend()) {
+        return AttributeTarget();
+      }
+
+      AttributeTarget target;
+      target.name = it_name->second;
+      target.group = ConvertGroupType(fromAttr);
+      target.type = ConvertAttribType(fromAttr);
+      target.convert = target.type != INVALID_ATTRIB;
+      return target;
+    }
+
     template <class T>
     Matrix4 ConvertMatrix4(const T& from)
     {
@@ -634,57 +1303,205 @@ namespace Foundry
       }
     }
 
-    void ConvertValues(Attribute* toAttr, const UsdAttribute& fromAttr,
-                       const UsdTimeCode time, int offset, int stride)
+    namespace
     {
-      switch(toAttr->type()) {
-        case INT_ATTRIB: {
-          VtIntArray vals;
-          ComputePrimvar(vals, fromAttr, time);
-          FillNumericValue(toAttr, GetOffsetArray(vals, offset, stride));
-          break;
+      /// View of the values at an offset, or of all of them when the offset or stride is -1
+      template <class T>
+      ArraySpan<T> OffsetSpan(const VtArray<T>& source, int offset, int stride)
+      {
+        if(offset == -1 || stride == -1) {
+          return source;
         }
-        case FLOAT_ATTRIB: {
-          VtFloatArray vals;
-          ComputePrimvar(vals, fromAttr, time);
-          FillNumericValue(toAttr, GetOffsetArray(vals, offset, stride));
-          break;
+        return ArraySpan<T>(source, static_cast<size_t>(offset),
+                            static_cast<size_t>(stride));
+      }
+    }  // namespace
+
+    namespace
+    {
+      /*! Decode half values straight into the float storage of a Nuke attribute list
+       * \return False if the attribute's values couldn't be read as HALF
+       */
+      template <class HALF, class LIST>
+      bool DecodeHalfValues(LIST& toList, const AttributeSource& fromAttr,
+                            const UsdTimeCode time, int offset, int stride)
+      {
+        using Element = typename LIST::value_type;
+        static_assert(sizeof(Element) * sizeof(GfHalf) ==
+                          sizeof(HALF) * sizeof(float),
+                      "Nuke elements hold one float per half component");
+        VtArray<HALF> vals;
+        if(!_ComputePrimvar(vals, fromAttr, time)) {
+          return false;
         }
-        case VECTOR2_ATTRIB: {
-          VtVec2fArray vals;
-          ComputePrimvar(vals, fromAttr, time);
-          FillVectorValue(toAttr, GetOffsetArray(vals, offset, stride));
-          break;
+        const ArraySpan<HALF> span = OffsetSpan(vals, offset, stride);
+        toList.resize(span.size());
+        if(!span.empty()) {
+          DecodeHalfs(reinterpret_cast<const GfHalf*>(span.begin()),
+                      span.size() * sizeof(HALF) / sizeof(GfHalf),
+                      reinterpret_cast<float*>(&toList[0]));
         }
-        // Normals are Vector3s
-        case NORMAL_ATTRIB:
-        case VECTOR3_ATTRIB: {
-          VtVec3fArray vals;
-          ComputePrimvar(vals, fromAttr, time);
-          FillVectorValue(toAttr, GetOffsetArray(vals, offset, stride));
-          break;
-        }
-        case VECTOR4_ATTRIB: {
-          VtVec4fArray vals;
-          ComputePrimvar(vals, fromAttr, time);
-          FillVectorValue(toAttr, GetOffsetArray(vals, offset, stride));
-          break;
+        return true;
+      }
+
+      /*! Flatten an indexed primvar straight into a Nuke attribute list, reading
+       * the values and indices raw instead of through ComputeFlattened
+       * \return False if the attribute isn't an indexed primvar of type T
+       */
+      template <class T, class LIST, class CONVERT>
+      bool GatherIndexedValues(LIST& toList, const AttributeSource& fromAttr,
+                               const UsdTimeCode time, int offset, int stride,
+                               CONVERT&& convert,
+                               const typename LIST::value_type& fallback)
+      {
+        VtArray<T> values;
+        VtIntArray indices;
+        if(!ComputeIndexedPrimvar(values, indices, fromAttr, time)) {
+          return false;
         }
-        case MATRIX3_ATTRIB: {
-          VtArray<GfMatrix3d> vals;
-          ComputePrimvar(vals, fromAttr, time);
-          FillMatrixValue(toAttr, GetOffsetArray(vals, offset, stride));
-          break;
+        // Each element has its own index, so instances slice the indices
+        GatherIndexed(ArraySpan<T>(values), OffsetSpan(indices, offset, stride),
+                      toList, convert, fallback);
+        return true;
+      }
+
+      /*! Convert indexed primvars of the value type of the Nuke attribute by
+       * gathering their values in parallel
+       * \return False if the attribute isn't an indexed primvar of that type
+       */
+      bool ConvertIndexedValues(Attribute* toAttr,
+                                const AttributeSource& fromAttr,
+                                const UsdTimeCode time, int offset, int stride)
+      {
+        switch(toAttr->type()) {
+          case INT_ATTRIB:
+            return GatherIndexedValues<int>(
+                *toAttr->int_list, fromAttr, time, offset, stride,
+                [](int value) { return value; }, 0);
+          case FLOAT_ATTRIB:
+            return GatherIndexedValues<float>(
+                *toAttr->float_list, fromAttr, time, offset, stride,
+                [](float value) { return value; }, 0.0f);
+          case VECTOR2_ATTRIB:
+            return GatherIndexedValues<GfVec2f>(
+                *toAttr->vector2_list, fromAttr, time, offset, stride,
+                [](const GfVec2f& v) { return Vector2(v[0], v[1]); },
+                Vector2(0.0f, 0.0f));
+          // Normals are Vector3s
+          case NORMAL_ATTRIB:
+          case VECTOR3_ATTRIB:
+            return GatherIndexedValues<GfVec3f>(
+                *toAttr->vector3_list, fromAttr, time, offset, stride,
+                [](const GfVec3f& v) { return Vector3(v[0], v[1], v[2]); },
+                Vector3(0.0f, 0.0f, 0.0f));
+          case VECTOR4_ATTRIB:
+            return GatherIndexedValues<GfVec4f>(
+                *toAttr->vector4_list, fromAttr, time, offset, stride,
+                [](const GfVec4f& v) {
+                  return Vector4(v[0], v[1], v[2], v[3]);
+                },
+                Vector4(0.0f, 0.0f, 0.0f, 0.0f));
+          default:
+            return false;
         }
-        case MATRIX4_ATTRIB: {
-          VtArray<GfMatrix4d> vals;
-          ComputePrimvar(vals, fromAttr, time);
-          FillMatrixValue(toAttr, GetOffsetArray(vals, offset, stride));
-          break;
+      }
+
+      /*! Convert half, half2, half3 and half4 attributes into the float attribute
+       * of the same dimension without going through a float array
+       * \return False if the attribute doesn't hold halves of the Nuke attribute's dimension
+       */
+      bool ConvertHalfValues(Attribute* toAttr, const AttributeSource& fromAttr,
+                             const UsdTimeCode time, int offset, int stride)
+      {
+        const TfType source = fromAttr.attr.GetTypeName().GetType();
+        switch(toAttr->type()) {
+          case FLOAT_ATTRIB:
+            return source.IsA<VtHalfArray>() &&
+                   DecodeHalfValues<GfHalf>(*toAttr->float_list, fromAttr,
+                                            time, offset, stride);
+          case VECTOR2_ATTRIB:
+            return source.IsA<VtVec2hArray>() &&
+                   DecodeHalfValues<GfVec2h>(*toAttr->vector2_list, fromAttr,
+                                             time, offset, stride);
+          // Normals are Vector3s
+          case NORMAL_ATTRIB:
+          case VECTOR3_ATTRIB:
+            return source.IsA<VtVec3hArray>() &&
+                   DecodeHalfValues<GfVec3h>(*toAttr->vector3_list, fromAttr,
+                                             time, offset, stride);
+          case VECTOR4_ATTRIB:
+            return source.IsA<VtVec4hArray>() &&
+                   DecodeHalfValues<GfVec4h>(*toAttr->vector4_list, fromAttr,
+                                             time, offset, stride);
+          default:
+            return false;
         }
-        default:
+      }
+
+      void ConvertSourceValues(Attribute* toAttr,
+                               const AttributeSource& fromAttr,
+                               const UsdTimeCode time, int offset, int stride)
+      {
+        if(ConvertIndexedValues(toAttr, fromAttr, time, offset, stride) ||
+           ConvertHalfValues(toAttr, fromAttr, time, offset, stride)) {
           return;
+        }
+        switch(toAttr->type()) {
+          case INT_ATTRIB: {
+            VtIntArray vals;
+            _ComputeConverted(vals, fromAttr, time);
+            FillNumericValue(toAttr, OffsetSpan(vals, offset, stride));
+            break;
+          }
+          case FLOAT_ATTRIB: {
+            VtFloatArray vals;
+            _ComputeConverted(vals, fromAttr, time);
+            FillNumericValue(toAttr, OffsetSpan(vals, offset, stride));
+            break;
+          }
+          case VECTOR2_ATTRIB: {
+            VtVec2fArray vals;
+            _ComputeConverted(vals, fromAttr, time);
+            FillVectorValue(toAttr, OffsetSpan(vals, offset, stride));
+            break;
+          }
+          // Normals are Vector3s
+          case NORMAL_ATTRIB:
+          case VECTOR3_ATTRIB: {
+            VtVec3fArray vals;
+            _ComputeConverted(vals, fromAttr, time);
+            FillVectorValue(toAttr, OffsetSpan(vals, offset, stride));
+            break;
+          }
+          case VECTOR4_ATTRIB: {
+            VtVec4fArray vals;
+            _ComputeConverted(vals, fromAttr, time);
+            FillVectorValue(toAttr, OffsetSpan(vals, offset, stride));
+            break;
+          }
+          case MATRIX3_ATTRIB: {
+            VtArray<GfMatrix3d> vals;
+            _ComputeConverted(vals, fromAttr, time);
+            FillMatrixValue(toAttr, OffsetSpan(vals, offset, stride));
+            break;
+          }
+          case MATRIX4_ATTRIB: {
+            VtArray<GfMatrix4d> vals;
+            _ComputeConverted(vals, fromAttr, time);
+            FillMatrixValue(toAttr, OffsetSpan(vals, offset, stride));
+            break;
+          }
+          default:
+            return;
+        }
       }
+    }  // namespace
+
+    void ConvertValues(Attribute* toAttr, const UsdAttribute& fromAttr,
+                       const UsdTimeCode time, int offset, int stride)
+    {
+      ConvertSourceValues(toAttr, AttributeSource(fromAttr), time, offset,
+                          stride);
     }
 
     void ConvertPrimPath(GeometryList& out, int obj, const UsdPrim& prim)
@@ -694,43 +1511,250 @@ namespace Foundry
       FillStringValue(attr, prim.GetPath().GetString());
     }
 
-    Attribute* ConstructAttribute(GeometryList& out, const int obj,
-                                  const UsdAttribute& fromAttr)
+    void ConvertPrimPath(GeometryList& out, int obj, const UsdPrim& prim,
+                         size_t chunk)
+    {
+      Attribute* attr = out.writable_attribute(obj, Group_Object, kNameAttrName,
+                                               STD_STRING_ATTRIB);
+      FillStringValue(attr, prim.GetPath().GetString() + ":chunk" +
+                                std::to_string(chunk));
+    }
+
+    const std::vector<const char*>& ConvertedAttributeNames()
+    {
+      static const std::vector<const char*> names{
+          nukeTokens.N.GetText(),   nukeTokens.Cf.GetText(),
+          nukeTokens.PW.GetText(),  nukeTokens.vel.GetText(),
+          nukeTokens.size.GetText(), nukeTokens.uv.GetText()};
+      return names;
+    }
+
+    namespace
     {
-      if(!fromAttr.HasValue()) {
-        return nullptr;
+      template <class LIST>
+      void CopyElements(const LIST& from, const std::vector<unsigned>* indices,
+                        LIST& to)
+      {
+        if(!indices) {
+          if(&from != &to) {
+            to = from;
+          }
+          return;
+        }
+        if(&from != &to) {
+          to.resize(indices->size());
+        }
+        for(size_t i = 0; i < indices->size(); ++i) {
+          to[i] = from[(*indices)[i]];
+        }
+        to.resize(indices->size());
       }
+    }  // namespace
 
-      TfToken name = ConvertName(fromAttr);
-      if(name == fromAttr.GetName()) {
-        return nullptr;
+    void CopyAttributeElements(const Attribute& from,
+                               const std::vector<unsigned>* indices,
+                               Attribute& to)
+    {
+      switch(from.type()) {
+        case FLOAT_ATTRIB:
+          CopyElements(*from.float_list, indices, *to.float_list);
+          break;
+        case INT_ATTRIB:
+          CopyElements(*from.int_list, indices, *to.int_list);
+          break;
+        case VECTOR2_ATTRIB:
+          CopyElements(*from.vector2_list, indices, *to.vector2_list);
+          break;
+        // Normals are Vector3s
+        case NORMAL_ATTRIB:
+        case VECTOR3_ATTRIB:
+          CopyElements(*from.vector3_list, indices, *to.vector3_list);
+          break;
+        case VECTOR4_ATTRIB:
+          CopyElements(*from.vector4_list, indices, *to.vector4_list);
+          break;
+        case MATRIX3_ATTRIB:
+          CopyElements(*from.matrix3_list, indices, *to.matrix3_list);
+          break;
+        case MATRIX4_ATTRIB:
+          CopyElements(*from.matrix4_list, indices, *to.matrix4_list);
+          break;
+        case STD_STRING_ATTRIB:
+          CopyElements(*from.std_string_list, indices, *to.std_string_list);
+          break;
+        default:
+          break;
       }
+    }
 
-      GroupType group = ConvertGroupType(fromAttr);
-      AttribType attrType = ConvertAttribType(fromAttr);
-      if(attrType == INVALID_ATTRIB) {
-        return nullptr;
+    namespace
+    {
+      template <class LIST>
+      void CopyRange(const LIST& from, size_t begin, size_t end, LIST& to)
+      {
+        if(begin > end || end > from.size()) {
+          to.clear();
+          return;
+        }
+        to.assign(from.begin() + begin, from.begin() + end);
       }
+    }  // namespace
 
-      return out.writable_attribute(obj, group, name.GetText(), attrType);
+    void CopyAttributeRange(const Attribute& from, size_t begin, size_t end,
+                            Attribute& to)
+    {
+      switch(from.type()) {
+        case FLOAT_ATTRIB:
+          CopyRange(*from.float_list, begin, end, *to.float_list);
+          break;
+        case INT_ATTRIB:
+          CopyRange(*from.int_list, begin, end, *to.int_list);
+          break;
+        case VECTOR2_ATTRIB:
+          CopyRange(*from.vector2_list, begin, end, *to.vector2_list);
+          break;
+        // Normals are Vector3s
+        case NORMAL_ATTRIB:
+        case VECTOR3_ATTRIB:
+          CopyRange(*from.vector3_list, begin, end, *to.vector3_list);
+          break;
+        case VECTOR4_ATTRIB:
+          CopyRange(*from.vector4_list, begin, end, *to.vector4_list);
+          break;
+        case MATRIX3_ATTRIB:
+          CopyRange(*from.matrix3_list, begin, end, *to.matrix3_list);
+          break;
+        case MATRIX4_ATTRIB:
+          CopyRange(*from.matrix4_list, begin, end, *to.matrix4_list);
+          break;
+        case STD_STRING_ATTRIB:
+          CopyRange(*from.std_string_list, begin, end, *to.std_string_list);
+          break;
+        default:
+          break;
+      }
+    }
+
+    namespace
+    {
+      template <class LIST>
+      void AppendElements(const LIST& from, LIST& to)
+      {
+        to.insert(to.end(), from.begin(), from.end());
+      }
+    }  // namespace
+
+    void AppendAttributeElements(const Attribute& from, Attribute& to)
+    {
+      switch(from.type()) {
+        case FLOAT_ATTRIB:
+          AppendElements(*from.float_list, *to.float_list);
+          break;
+        case INT_ATTRIB:
+          AppendElements(*from.int_list, *to.int_list);
+          break;
+        case VECTOR2_ATTRIB:
+          AppendElements(*from.vector2_list, *to.vector2_list);
+          break;
+        // Normals are Vector3s
+        case NORMAL_ATTRIB:
+        case VECTOR3_ATTRIB:
+          AppendElements(*from.vector3_list, *to.vector3_list);
+          break;
+        case VECTOR4_ATTRIB:
+          AppendElements(*from.vector4_list, *to.vector4_list);
+          break;
+        case MATRIX3_ATTRIB:
+          AppendElements(*from.matrix3_list, *to.matrix3_list);
+          break;
+        case MATRIX4_ATTRIB:
+          AppendElements(*from.matrix4_list, *to.matrix4_list);
+          break;
+        case STD_STRING_ATTRIB:
+          AppendElements(*from.std_string_list, *to.std_string_list);
+          break;
+        default:
+          break;
+      }
+    }
+
+    Attribute* ConstructAttribute(GeometryList& out, const int obj,
+                                  const UsdAttribute& fromAttr)
+    {
+      return ConstructAttributeWith(AttributeSource(fromAttr),
+                                    ObjectAttributes(out, obj));
     }
 
     FN_USDCONVERTER_API void ConvertUsdAttributes(
         GeometryList& out, const int obj,
         const std::vector<UsdAttribute>& primvars, const UsdTimeCode time)
     {
-      ColorUvData data;
-      // Convert attributes first that don't map to Nuke ones directly, then convert what remains
-      UsdAttributeVector remainingAttributes =
-          ConvertMismatchedAttributes(data, primvars, time);
-      ConvertColorUvs(out, obj, data);
-      for(auto& fromAttr : remainingAttributes) {
-        Attribute* toAttr = ConstructAttribute(out, obj, fromAttr);
-        if(!toAttr) {
-          continue;
-        }
-        ConvertValues(toAttr, fromAttr, time);
+      ConvertUsdAttributesWith(primvars, time, out[obj].points(), nullptr,
+                               ObjectAttributes(out, obj));
+    }
+
+    FN_USDCONVERTER_API void ConvertUsdAttributes(
+        GeometryList& out, const int obj,
+        const std::vector<UsdAttribute>& primvars, const ConversionContext& ctx)
+    {
+      ConvertUsdAttributesWith(primvars, ctx.time, out[obj].points(), ctx.cache,
+                               ObjectAttributes(out, obj));
+    }
+
+    bool ConvertUsdAttribute(const UsdAttribute& fromAttr,
+                             const UsdTimeCode time, ConvertedAttribute* toAttr,
+                             ConversionCache* cache, int* elementSize)
+    {
+      // Queries are only kept for the attributes with a Nuke counterpart
+      const auto queries = mappedNames.count(fromAttr.GetName()) > 0
+                               ? FindQueries(cache, fromAttr)
+                               : nullptr;
+      const AttributeSource source(fromAttr, queries.get());
+      Attribute* converted = ConstructAttributeWith(
+          source,
+          [toAttr](const TfToken& name, GroupType group, AttribType type) {
+            *toAttr = {name.GetString(), group,
+                       std::make_shared<Attribute>(name.GetText(), type)};
+            return toAttr->attribute.get();
+          });
+      if(!converted) {
+        return false;
+      }
+      ConvertSourceValues(converted, source, time, -1, -1);
+      if(elementSize) {
+        *elementSize = source.elementSize();
       }
+      return true;
+    }
+
+    namespace
+    {
+      std::vector<ConvertedAttribute> ConvertToOwnAttributes(
+          const std::vector<UsdAttribute>& primvars, const UsdTimeCode time,
+          ConversionCache* cache)
+      {
+        std::vector<ConvertedAttribute> converted;
+        ConvertUsdAttributesWith(
+            primvars, time, 0, cache,
+            [&converted](const TfToken& name, GroupType group, AttribType type) {
+              auto attribute = std::make_shared<Attribute>(name.GetText(), type);
+              converted.push_back({name.GetString(), group, attribute});
+              return attribute.get();
+            });
+        return converted;
+      }
+    }  // namespace
+
+    std::vector<ConvertedAttribute> ConvertUsdAttributes(
+        const std::vector<UsdAttribute>& primvars, const UsdTimeCode time)
+    {
+      return ConvertToOwnAttributes(primvars, time, nullptr);
+    }
+
+    std::vector<ConvertedAttribute> ConvertUsdAttributes(
+        const std::vector<UsdAttribute>& primvars, const ConversionContext& ctx)
+    {
+      return ConvertToOwnAttributes(primvars, ctx.time, ctx.cache);
     }
   }  // namespace UsdConverter
 }  // namespace Foundry
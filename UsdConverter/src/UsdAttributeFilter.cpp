@@ -0,0 +1,130 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Implementation file for choosing which USD attributes a load converts
+ */
+
+#include "UsdConverter/UsdAttributeFilter.h"
+
+#include <pxr/usd/usdGeom/tokens.h>
+
+#include <sstream>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    namespace
+    {
+      std::vector<std::string> SplitPatterns(const std::string& patterns)
+      {
+        std::vector<std::string> split;
+        std::istringstream stream(patterns);
+        std::string pattern;
+        while(stream >> pattern) {
+          split.push_back(pattern);
+        }
+        return split;
+      }
+
+      const std::string kPrimvarsPrefix = "primvars:";
+
+      bool MatchAny(const std::vector<std::string>& patterns,
+                    const std::string& name)
+      {
+        for(const auto& pattern : patterns) {
+          if(MatchGlob(pattern, name)) {
+            return true;
+          }
+          // Primvars also match without their namespace
+          if(name.compare(0, kPrimvarsPrefix.size(), kPrimvarsPrefix) == 0 &&
+             MatchGlob(pattern, name.substr(kPrimvarsPrefix.size()))) {
+            return true;
+          }
+        }
+        return false;
+      }
+    }  // namespace
+
+    bool MatchGlob(const std::string& pattern, const std::string& name)
+    {
+      // Greedy matching, backtracking to the last * on a mismatch
+      size_t p = 0;
+      size_t n = 0;
+      size_t star = std::string::npos;
+      size_t starName = 0;
+      while(n < name.size()) {
+        if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+          ++p;
+          ++n;
+        }
+        else if(p < pattern.size() && pattern[p] == '*') {
+          star = p++;
+          starName = n;
+        }
+        else if(star != std::string::npos) {
+          p = star + 1;
+          n = ++starName;
+        }
+        else {
+          return false;
+        }
+      }
+      while(p < pattern.size() && pattern[p] == '*') {
+        ++p;
+      }
+      return p == pattern.size();
+    }
+
+    AttributeFilter::AttributeFilter(const std::string& include,
+                                     const std::string& exclude)
+        : _include(SplitPatterns(include)), _exclude(SplitPatterns(exclude))
+    {
+    }
+
+    bool AttributeFilter::operator()(const UsdAttribute& attr) const
+    {
+      const std::string& name = attr.GetName().GetString();
+      return (_include.empty() || MatchAny(_include, name)) &&
+             !MatchAny(_exclude, name);
+    }
+
+    std::vector<UsdAttribute> AttributeFilter::filter(
+        const std::vector<UsdAttribute>& attrs) const
+    {
+      std::vector<UsdAttribute> kept;
+      kept.reserve(attrs.size());
+      for(const auto& attr : attrs) {
+        // The points and the face vertex indices that colors are promoted through
+        if(attr.GetName() == UsdGeomTokens->points ||
+           attr.GetName() == UsdGeomTokens->faceVertexIndices || (*this)(attr)) {
+          kept.push_back(attr);
+        }
+      }
+      return kept;
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
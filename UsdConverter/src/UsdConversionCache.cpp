@@ -0,0 +1,261 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Implementation file for the UsdConverter cache kept alive between loads
+ */
+
+#include "UsdConverter/UsdConversionCache.h"
+
+#include <pxr/usd/usd/stagePopulationMask.h>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    UsdStageRefPtr ConversionCache::stage(
+        const std::string& filename, const std::vector<std::string>& maskPaths)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_stage && filename == _filename && maskPaths == _maskPaths) {
+        return _stage;
+      }
+
+      // Everything cached so far belongs to the previous stage
+      _animation.reset();
+      _pointSamples.clear();
+      _bracketingSamples.clear();
+      _instanceTransforms.clear();
+      _instancerPrototypes.clear();
+      _prototypeTemplates.clear();
+      clearStageData();
+
+      UsdStagePopulationMask mask(maskPaths.begin(), maskPaths.end());
+      _stage = UsdStage::OpenMasked(filename, mask);
+      _filename = filename;
+      _maskPaths = maskPaths;
+      return _stage;
+    }
+
+    void ConversionCache::clear()
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stage.Reset();
+      _filename.clear();
+      _maskPaths.clear();
+      _animation.reset();
+      _pointSamples.clear();
+      _bracketingSamples.clear();
+      _instanceTransforms.clear();
+      _instancerPrototypes.clear();
+      _prototypeTemplates.clear();
+      clearStageData();
+    }
+
+    StageAnimation ConversionCache::animation(
+        const std::string& filename, const std::vector<std::string>& maskPaths)
+    {
+      const UsdStageRefPtr opened = stage(filename, maskPaths);
+      if(!opened) {
+        StageAnimation everything;
+        everything.topology = true;
+        everything.points = true;
+        everything.instances = true;
+        return everything;
+      }
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_animation && _stage == opened) {
+          return *_animation;
+        }
+      }
+
+      // Traverse outside of the lock, so other prims can be converted meanwhile
+      const StageAnimation animation = ComputeStageAnimation(opened);
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_stage == opened) {
+        _animation = std::make_unique<StageAnimation>(animation);
+      }
+      return animation;
+    }
+
+    std::shared_ptr<const PointSamples> ConversionCache::pointSamples(
+        const UsdGeomPointBased& fromPrim, UsdTimeCode time)
+    {
+      if(!time.IsNumeric()) {
+        return nullptr;
+      }
+      double lower, upper;
+      bool hasTimeSamples = false;
+      if(!fromPrim.GetPointsAttr().GetBracketingTimeSamples(
+             time.GetValue(), &lower, &upper, &hasTimeSamples) ||
+         !hasTimeSamples || lower == time.GetValue()) {
+        return nullptr;
+      }
+
+      const SdfPath& path = fromPrim.GetPath();
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _pointSamples.find(path);
+        if(it != _pointSamples.cend() && it->second->time == lower) {
+          return it->second;
+        }
+      }
+
+      // Read outside of the lock, so other prims can be converted meanwhile
+      auto samples = std::make_shared<PointSamples>();
+      if(!ReadPointSamples(fromPrim, time, samples.get())) {
+        return nullptr;
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      _pointSamples[path] = samples;
+      return samples;
+    }
+
+    std::shared_ptr<const BracketingSamples> ConversionCache::bracketingSamples(
+        const UsdGeomPointBased& fromPrim, UsdTimeCode time)
+    {
+      if(!time.IsNumeric()) {
+        return nullptr;
+      }
+      double lower, upper;
+      bool hasTimeSamples = false;
+      if(!fromPrim.GetPointsAttr().GetBracketingTimeSamples(
+             time.GetValue(), &lower, &upper, &hasTimeSamples) ||
+         !hasTimeSamples || lower == upper || lower == time.GetValue()) {
+        return nullptr;
+      }
+
+      const SdfPath& path = fromPrim.GetPath();
+      std::shared_ptr<const BracketingSamples> previous;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _bracketingSamples.find(path);
+        if(it != _bracketingSamples.cend()) {
+          if(it->second->lowerTime == lower && it->second->upperTime == upper) {
+            return it->second;
+          }
+          previous = it->second;
+        }
+      }
+
+      // Read outside of the lock, so other prims can be converted meanwhile
+      auto samples = std::make_shared<BracketingSamples>();
+      if(!ReadBracketingSamples(fromPrim, time, previous.get(), samples.get())) {
+        return nullptr;
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      _bracketingSamples[path] = samples;
+      return samples;
+    }
+
+    std::shared_ptr<const InstanceTransformSamples>
+    ConversionCache::instanceTransforms(const UsdGeomPointInstancer& instancer,
+                                        const std::vector<double>& times)
+    {
+      const SdfPath& path = instancer.GetPath();
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _instanceTransforms.find(path);
+        if(it != _instanceTransforms.cend() && it->second->times == times) {
+          return it->second;
+        }
+      }
+
+      // Read outside of the lock, so other prims can be converted meanwhile
+      auto samples = std::make_shared<InstanceTransformSamples>();
+      if(!ReadInstanceTransformSamples(instancer, times, samples.get())) {
+        return nullptr;
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      _instanceTransforms[path] = samples;
+      return samples;
+    }
+
+    std::shared_ptr<const InstancerPrototypes>
+    ConversionCache::instancerPrototypes(
+        const UsdGeomPointInstancer& instancer)
+    {
+      const SdfPath& path = instancer.GetPath();
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _instancerPrototypes.find(path);
+        if(it != _instancerPrototypes.cend()) {
+          return it->second;
+        }
+      }
+
+      // Read outside of the lock, so other prims can be converted meanwhile
+      auto prototypes = std::make_shared<InstancerPrototypes>();
+      ReadInstancerPrototypes(instancer, prototypes.get());
+      std::lock_guard<std::mutex> lock(_mutex);
+      _instancerPrototypes[path] = prototypes;
+      return prototypes;
+    }
+
+    std::shared_ptr<const PrototypeTemplate> ConversionCache::prototypeTemplate(
+        const SdfPath& instancer, const SdfPath& prim, size_t fingerprint)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const auto it = _prototypeTemplates.find(std::make_pair(instancer, prim));
+      if(it != _prototypeTemplates.cend() && it->second.first == fingerprint) {
+        return it->second.second;
+      }
+      return nullptr;
+    }
+
+    void ConversionCache::setPrototypeTemplate(
+        const SdfPath& instancer, const SdfPath& prim, size_t fingerprint,
+        std::shared_ptr<const PrototypeTemplate> prototype)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _prototypeTemplates[std::make_pair(instancer, prim)] =
+          std::make_pair(fingerprint, std::move(prototype));
+    }
+
+    std::shared_ptr<const AttributeQueries> ConversionCache::attributeQueries(
+        const UsdAttribute& attr)
+    {
+      const SdfPath& path = attr.GetPath();
+      {
+        std::lock_guard<std::mutex> lock(_queriesMutex);
+        const auto it = _attributeQueries.find(path);
+        if(it != _attributeQueries.cend()) {
+          return it->second;
+        }
+      }
+
+      // Resolved outside of the lock, so other attributes can be read meanwhile
+      auto queries = std::make_shared<const AttributeQueries>(attr);
+      std::lock_guard<std::mutex> lock(_queriesMutex);
+      return _attributeQueries.emplace(path, std::move(queries)).first->second;
+    }
+
+    void ConversionCache::clearStageData()
+    {
+      std::lock_guard<std::mutex> lock(_queriesMutex);
+      _attributeQueries.clear();
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
@@ -30,19 +30,30 @@
 #include <DDImage/RenderParticles.h>
 #include <DDImage/SceneItem.h>
 #include <UsdConverter/UsdAttrConverter.h>
+#include <UsdConverter/UsdConversionContext.h>
 #include <UsdConverter/UsdGeoConverter.h>
 #include <UsdConverter/UsdCommon.h>
+#include <UsdConverter/UsdHierarchy.h>
+#include <UsdConverter/UsdInstancerPrototypes.h>
+#include <UsdConverter/UsdMeshBatches.h>
+#include <UsdConverter/UsdMeshChunks.h>
 #include <UsdConverter/UsdUI.h>
+#include <pxr/base/gf/transform.h>
+#include <pxr/base/work/loops.h>
 #include <pxr/usd/usd/primRange.h>
 #include <pxr/usd/usd/relationship.h>
+#include <pxr/usd/usdGeom/bboxCache.h>
 #include <pxr/usd/usdGeom/cube.h>
 #include <pxr/usd/usdGeom/mesh.h>
 #include <pxr/usd/usdGeom/pointInstancer.h>
 #include <pxr/usd/usdGeom/points.h>
 #include <pxr/usd/usdGeom/primvarsAPI.h>
-#include <pxr/usd/usdGeom/xformCache.h>
 #include <pxr/usd/usdGeom/metrics.h>
 
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
 using namespace DD::Image;
 
 namespace Foundry
@@ -73,6 +84,26 @@ namespace Foundry
       convertUsdGeometry(out, stage, time);
     }
 
+    FN_USDCONVERTER_API void loadUsd(GeometryList& out,
+                                     const std::string& filename,
+                                     const std::vector<std::string>& maskPaths,
+                                     const UsdTimeCode time,
+                                     ConversionCache& cache,
+                                     const ConversionOptions& options)
+    {
+      if(maskPaths.empty()) {
+        return;
+      }
+
+      // Reuse the stage opened by the previous load unless the file or masks changed
+      UsdStageRefPtr stage = cache.stage(filename, maskPaths);
+      if(!stage) {
+        return;
+      }
+
+      convertUsdGeometry(out, stage, time, &cache, options);
+    }
+
     /// Translate USD transform matrix to Nuke matrix
     void ConvertObjectTransform(GeometryList& out, const int obj,
                                 GfMatrix4d world)
@@ -118,34 +149,161 @@ namespace Foundry
     }
 
     // Add UsdGeomMesh to Nuke geometry list
-    template <>
-    FN_USDCONVERTER_API int addUsdPrim<UsdGeomMesh>(GeometryList& out,
-                                                    const UsdGeomMesh& fromPrim,
-                                                    const UsdTimeCode time)
+    int addUsdPrim(GeometryList& out, const UsdGeomMesh& fromPrim,
+                   const ConversionContext& ctx)
     {
       std::unique_ptr<PolyMesh> toPrim =
-          convertUsdPrim<UsdGeomMesh, PolyMesh>(fromPrim, time);
+          convertUsdPrim<UsdGeomMesh, PolyMesh>(fromPrim, ctx.time);
 
       const int obj = out.size();
       out.add_object(obj);
-      ConvertPoints(out, obj, fromPrim.GetPointsAttr(), time);
+      ConvertPoints(out, obj, fromPrim, ctx);
       // The geometry op will delete the prim
       out.add_primitive(obj, toPrim.release());
       return obj;
     }
 
-    // Add UsdGeomPoints to Nuke geometry list
     template <>
-    FN_USDCONVERTER_API int addUsdPrim<UsdGeomPoints>(
-        GeometryList& out, const UsdGeomPoints& fromPrim,
-        const UsdTimeCode time)
+    FN_USDCONVERTER_API int addUsdPrim<UsdGeomMesh>(GeometryList& out,
+                                                    const UsdGeomMesh& fromPrim,
+                                                    const UsdTimeCode time)
+    {
+      return addUsdPrim(out, fromPrim, ConversionContext(time));
+    }
+
+    /*! Add a mesh with more faces than the split option allows as several objects,
+     * each a chunk of neighbouring faces with its part of the points and attributes
+     * \return Geometry list index of the first chunk, the others follow it. -1 if
+     *         the mesh is small enough and nothing was added.
+     */
+    int AddMeshChunks(GeometryList& out, const UsdGeomMesh& fromPrim,
+                      const ConversionContext& ctx)
+    {
+      VtIntArray faceVertexCounts;
+      fromPrim.GetFaceVertexCountsAttr().Get(&faceVertexCounts, ctx.time);
+      if(faceVertexCounts.size() <= ctx.options.splitFaceCount) {
+        return -1;
+      }
+      VtIntArray faceVertexIndices;
+      fromPrim.GetFaceVertexIndicesAttr().Get(&faceVertexIndices, ctx.time);
+
+      // Convert the whole mesh's points and attributes into the first object,
+      // they are then distributed to the chunks from there
+      const int first = out.size();
+      out.add_object(first);
+      const size_t pointCount = ConvertPoints(out, first, fromPrim, ctx);
+      PointList* sourcePoints = out.writable_points(first);
+      std::vector<MeshChunk> chunks = SplitMesh(
+          faceVertexCounts, faceVertexIndices,
+          reinterpret_cast<const float*>(sourcePoints->data()), pointCount,
+          ctx.options.splitFaceCount);
+      ConvertUsdAttributes(
+          out, first,
+          ctx.filterAttributes(ctx.primAttributes(fromPrim.GetPrim())), ctx);
+      if(chunks.empty()) {
+        // Invalid topology can't be split, convert it as one object like any other mesh
+        out.add_primitive(
+            first,
+            convertUsdPrim<UsdGeomMesh, PolyMesh>(fromPrim, ctx.time).release());
+        return first;
+      }
+
+      TfToken orientation;
+      fromPrim.GetOrientationAttr().Get(&orientation);
+      const bool leftHanded = orientation == UsdGeomTokens->leftHanded;
+
+      // Build the chunks' primitives in parallel, the geometry list itself isn't thread safe
+      std::vector<std::unique_ptr<PolyMesh>> meshes(chunks.size());
+      WorkParallelForN(chunks.size(), [&](size_t begin, size_t end) {
+        for(size_t c = begin; c < end; ++c) {
+          MeshChunk& chunk = chunks[c];
+          meshes[c] = std::make_unique<PolyMesh>(
+              chunk.faceVertexIndices.size(), chunk.faceVertexCounts.size());
+          int* vertices = chunk.faceVertexIndices.data();
+          for(const int count : chunk.faceVertexCounts) {
+            meshes[c]->add_face(count, vertices, leftHanded);
+            vertices += count;
+          }
+        }
+      });
+
+      // Create the chunk objects and their attributes up front, then fill them in parallel
+      struct Copy
+      {
+        const Attribute* from;
+        Attribute* to;
+        const std::vector<unsigned>* indices;
+      };
+      std::vector<std::vector<Copy>> copies(chunks.size());
+      std::vector<PointList*> chunkPoints(chunks.size());
+      for(size_t c = 1; c < chunks.size(); ++c) {
+        out.add_object(first + static_cast<int>(c));
+      }
+      for(size_t c = 0; c < chunks.size(); ++c) {
+        const int obj = first + static_cast<int>(c);
+        chunkPoints[c] = out.writable_points(obj);
+        // The geometry op will delete the prim
+        out.add_primitive(obj, meshes[c].release());
+      }
+      sourcePoints = chunkPoints[0];
+      for(const char* name : ConvertedAttributeNames()) {
+        for(const GroupType group :
+            {Group_Object, Group_Primitives, Group_Points, Group_Vertices}) {
+          const auto* existing = out[first].get_group_attribute(group, name);
+          if(!existing) {
+            continue;
+          }
+          Attribute* from =
+              out.writable_attribute(first, group, name, existing->type());
+          for(size_t c = 0; c < chunks.size(); ++c) {
+            const int obj = first + static_cast<int>(c);
+            Attribute* to =
+                c == 0 ? from
+                       : out.writable_attribute(obj, group, name, from->type());
+            // Object and primitive attributes are shared by all the faces of the mesh
+            const std::vector<unsigned>* indices =
+                group == Group_Points
+                    ? &chunks[c].points
+                    : (group == Group_Vertices ? &chunks[c].vertices : nullptr);
+            copies[c].push_back({from, to, indices});
+          }
+        }
+      }
+
+      const auto fillChunk = [&](size_t c) {
+        const MeshChunk& chunk = chunks[c];
+        PointList& toPoints = *chunkPoints[c];
+        if(c > 0) {
+          toPoints.resize(chunk.points.size());
+        }
+        // The chunk elements are ascending, so the first chunk can be compacted in place
+        for(size_t p = 0; p < chunk.points.size(); ++p) {
+          toPoints[p] = (*sourcePoints)[chunk.points[p]];
+        }
+        toPoints.resize(chunk.points.size());
+        for(const Copy& copy : copies[c]) {
+          CopyAttributeElements(*copy.from, copy.indices, *copy.to);
+        }
+      };
+      // The first chunk reads the data in the place it compacts, so it goes last
+      WorkParallelForN(chunks.size() - 1, [&](size_t begin, size_t end) {
+        for(size_t c = begin; c < end; ++c) {
+          fillChunk(c + 1);
+        }
+      });
+      fillChunk(0);
+      return first;
+    }
+
+    // Add UsdGeomPoints to Nuke geometry list
+    int addUsdPrim(GeometryList& out, const UsdGeomPoints& fromPrim,
+                   const ConversionContext& ctx)
     {
       // Add new Nuke geometry list object
       const int obj = out.size();
       out.add_object(obj);
       // Write USD points into the new Nuke object's points
-      const auto nPoints =
-          ConvertPoints(out, obj, fromPrim.GetPointsAttr(), time);
+      const auto nPoints = ConvertPoints(out, obj, fromPrim, ctx);
       const float pointSize = 1.0f;
       // Create Nuke particles object using the points
       Particles* particles =
@@ -156,145 +314,12 @@ namespace Foundry
       return obj;
     }
 
-    // Helper for adding point instancer geometry
-    int AddInstancedPrim(GeometryList& out, const UsdPrim& instance,
-                         const int proto,
-                         const std::vector<UsdAttribute>& primAttributes,
-                         const std::vector<UsdAttribute>& constantAttributes,
-                         const std::vector<UsdAttribute>& remainingAttributes,
-                         bool pointInstancerTransforms,
-                         const VtArray<GfMatrix4d>& xforms,
-                         const ColorUvData& instancerData,
-                         const UsdTimeCode time)
-    {
-      UsdAttributeVector instanceAttributes = instance.GetAttributes();
-      const auto hasInstancerAttribute = [&](const auto& attribute) {
-        return std::any_of(
-            primAttributes.begin(), primAttributes.end(),
-            [&](const auto& pAttribute) {
-              return (pAttribute.GetName() == attribute.GetName());
-            });
-      };
-      // Apply the attributes that the instancer doesn't override
-      instanceAttributes.resize(std::distance(
-          instanceAttributes.begin(),
-          std::remove_if(instanceAttributes.begin(), instanceAttributes.end(),
-                         hasInstancerAttribute)));
-      // Also apply all the attributes that the instancer sets constantly
-      instanceAttributes.insert(instanceAttributes.begin(),
-                                constantAttributes.begin(),
-                                constantAttributes.end());
-      const auto instanceObj = addUsdPrim(out, instance, time);
-      if(instanceObj == -1) {
-        return instanceObj;
-      }
-      ConvertUsdAttributes(out, instanceObj, instanceAttributes, time);
-
-      ColorUvData instanceData(instancerData, proto);
-      // Apply the attributes that the instancer overrides
-      ConvertColorUvs(out, instanceObj, instanceData);
-      for(const auto& attribute : remainingAttributes) {
-        Attribute* toAttr = ConstructAttribute(out, instanceObj, attribute);
-        if(toAttr) {
-          ConvertValues(toAttr, attribute, time, proto,
-                        UsdGeomPrimvar(attribute).GetElementSize());
-        }
-      }
-      if(pointInstancerTransforms) {
-        ConvertObjectTransform(out, instanceObj, xforms[proto]);
-      }
-      else {
-        GfMatrix4d local;
-        bool resetsXFormStack;
-        UsdGeomXformable(instance).GetLocalTransformation(
-            &local, &resetsXFormStack, time);
-        ConvertObjectTransform(out, instanceObj, local);
-      }
-      return instanceObj;
-    }
-
-    // Add UsdGeomPointInstancer to Nuke geometry list
     template <>
-    FN_USDCONVERTER_API int addUsdPrim<UsdGeomPointInstancer>(
-        GeometryList& out, const UsdGeomPointInstancer& fromPrim,
+    FN_USDCONVERTER_API int addUsdPrim<UsdGeomPoints>(
+        GeometryList& out, const UsdGeomPoints& fromPrim,
         const UsdTimeCode time)
     {
-      UsdStageWeakPtr stage = fromPrim.GetPrim().GetStage();
-
-      UsdAttribute a_protoIndicies = fromPrim.GetProtoIndicesAttr();
-      VtIntArray protoIndices;
-      ComputePrimvar(protoIndices, a_protoIndicies, time);
-
-      UsdRelationship prototypes = fromPrim.GetPrototypesRel();
-      SdfPathVector paths;
-      prototypes.GetForwardedTargets(&paths);
-
-      std::vector<UsdAttribute> primAttributes =
-          fromPrim.GetPrim().GetAuthoredAttributes();
-
-      VtArray<GfMatrix4d> xforms;
-      const bool pointInstancerTransforms =
-          fromPrim.ComputeInstanceTransformsAtTime(&xforms, time, time);
-
-      UsdGeomXformCache cache(time);
-      const GfMatrix4d worldMatrix = cache.GetLocalToWorldTransform(fromPrim.GetPrim());
-      //Move xforms from local coordinates to world coordinates
-      for (size_t i = 0; i<xforms.size(); ++i)
-        xforms[i] *= worldMatrix;
-
-      // Split the attributes into those that need to be applied for all instances, and those that elementSize offsets
-      std::vector<UsdAttribute> constantAttributes;
-      std::vector<UsdAttribute> elementWiseAttributes;
-      for(const auto& pAttribute : primAttributes) {
-        TfToken interpolation = UsdGeomPrimvar(pAttribute).GetInterpolation();
-        if(interpolation == UsdGeomTokens->constant ||
-           interpolation == UsdGeomTokens->uniform) {
-          constantAttributes.push_back(pAttribute);
-        }
-        else {
-          elementWiseAttributes.push_back(pAttribute);
-        }
-      }
-      ColorUvData instancerData;
-      UsdAttributeVector remainingAttributes = ConvertMismatchedAttributes(
-          instancerData, elementWiseAttributes, time);
-
-      // Skip any invisible prototypes
-      std::vector<bool> maskedPrototypes = fromPrim.ComputeMaskAtTime(time);
-      // Fetch the prototypes and load them as objects into nuke
-      for(size_t proto = 0; proto < protoIndices.size(); ++proto) {
-        if(!maskedPrototypes.empty() && !maskedPrototypes[proto]) {
-          continue;
-        }
-        UsdPrim root = stage->GetPrimAtPath(paths[protoIndices[proto]]);
-        if(!root) {
-          continue;
-        }
-
-        const auto addInstance = [&out, &proto,
-                                  &primAttributes, &constantAttributes, &remainingAttributes,
-                                  &pointInstancerTransforms, &xforms,
-                                  &instancerData,
-                                  &time](auto& instance) {
-          AddInstancedPrim(out, instance, proto,
-                           primAttributes, constantAttributes, remainingAttributes,
-                           pointInstancerTransforms,  xforms,
-                           instancerData,
-                           time);
-        };
-
-        const auto allDescs = root.GetAllDescendants();
-        if(allDescs.empty()) {
-          addInstance(root);
-        }
-        else {
-          for(const auto& instance : allDescs) {
-            addInstance(instance);
-          }
-        }
-      }
-
-      return -1;
+      return addUsdPrim(out, fromPrim, ConversionContext(time));
     }
 
     // Helpers for UsdGeomCube conversion
@@ -333,11 +358,854 @@ namespace Foundry
       }
     }  // namespace
 
-    // Add UsdGeomCube to Nuke geometry list
+    // Helpers for the crop box
+    namespace
+    {
+      /*! Check whether a bound overlaps the crop box
+       * \param bound     Bound in the local space of a prim
+       * \param world     World transform of the prim
+       * \param crop      World space crop box
+       * \return True if it overlaps, or if the bound is empty and can't be tested
+       */
+      bool InCropBox(const GfBBox3d& bound, const GfMatrix4d& world,
+                     const GfRange3d& crop)
+      {
+        if(bound.GetRange().IsEmpty()) {
+          return true;
+        }
+        const GfBBox3d worldBound(bound.GetRange(), bound.GetMatrix() * world);
+        return !GfRange3d::GetIntersection(worldBound.ComputeAlignedRange(),
+                                           crop)
+                    .IsEmpty();
+      }
+
+      /*! Get the bounds of the prototypes of an instancer, without the transforms
+       * of their roots, which the instance transforms already include. Authored
+       * extents are used where they exist.
+       * \return One bound per prototype path, empty if it has none
+       */
+      std::vector<GfBBox3d> PrototypeBounds(const UsdGeomPointInstancer& instancer,
+                                            const SdfPathVector& paths,
+                                            UsdTimeCode time)
+      {
+        const UsdStageWeakPtr stage = instancer.GetPrim().GetStage();
+        UsdGeomBBoxCache bboxCache(time, {UsdGeomTokens->default_});
+        std::vector<GfBBox3d> bounds(paths.size());
+        for(size_t p = 0; p < paths.size(); ++p) {
+          const UsdPrim root = stage->GetPrimAtPath(paths[p]);
+          if(root) {
+            bounds[p] = bboxCache.ComputeUntransformedBound(root);
+          }
+        }
+        return bounds;
+      }
+    }  // namespace
+
+    // Helpers for point instancer conversion
+    namespace
+    {
+      /// The prototype's attributes that the instancer doesn't override, and those it sets constantly
+      UsdAttributeVector InstanceAttributes(
+          const ConversionContext& ctx, const UsdPrim& instance,
+          const std::vector<UsdAttribute>& primAttributes,
+          const std::vector<UsdAttribute>& constantAttributes)
+      {
+        UsdAttributeVector instanceAttributes = ctx.primAttributes(instance);
+        TfToken::HashSet instancerNames;
+        for(const auto& pAttribute : primAttributes) {
+          instancerNames.insert(pAttribute.GetName());
+        }
+        const auto hasInstancerAttribute = [&](const auto& attribute) {
+          return instancerNames.count(attribute.GetName()) > 0;
+        };
+        // Apply the attributes that the instancer doesn't override
+        instanceAttributes.resize(std::distance(
+            instanceAttributes.begin(),
+            std::remove_if(instanceAttributes.begin(), instanceAttributes.end(),
+                           hasInstancerAttribute)));
+        // Also apply all the attributes that the instancer sets constantly
+        instanceAttributes.insert(instanceAttributes.begin(),
+                                  constantAttributes.begin(),
+                                  constantAttributes.end());
+        return instanceAttributes;
+      }
+
+      /// An element-wise attribute of the instancer, read once for all the instances
+      struct InstancerAttribute
+      {
+        ConvertedAttribute values;
+        /// Number of elements per instance
+        size_t elementSize = 1;
+      };
+
+      /// Read the element-wise attributes of the instancer that have a Nuke counterpart
+      std::vector<InstancerAttribute> ConvertInstancerAttributes(
+          const std::vector<UsdAttribute>& remainingAttributes,
+          const ConversionContext& ctx)
+      {
+        std::vector<InstancerAttribute> instancerAttributes;
+        for(const auto& attribute : remainingAttributes) {
+          InstancerAttribute converted;
+          // Read through the cached queries like the values
+          int elementSize = 1;
+          if(ConvertUsdAttribute(attribute, ctx.time, &converted.values,
+                                 ctx.cache, &elementSize)) {
+            converted.elementSize =
+                static_cast<size_t>(std::max(elementSize, 1));
+            instancerAttributes.push_back(std::move(converted));
+          }
+        }
+        return instancerAttributes;
+      }
+
+      /// The element-wise data of a nested instancer, read once for all its instances
+      struct InstancerOverrides
+      {
+        ColorUvData colorUvs;
+        std::vector<InstancerAttribute> attributes;
+      };
+
+      /// An instance of a nested instancer that a leaf prim was added for
+      struct NestedInstance
+      {
+        const InstancerOverrides* overrides = nullptr;
+        size_t instance = 0;
+      };
+
+      /// Copy the elementSize values of one instance of the instancer's attributes
+      void CopyInstanceAttributes(
+          GeometryList& out, const int obj, const size_t proto,
+          const std::vector<InstancerAttribute>& instancerAttributes)
+      {
+        for(const auto& attr : instancerAttributes) {
+          const ConvertedAttribute& values = attr.values;
+          Attribute* toAttr =
+              out.writable_attribute(obj, values.group, values.name.c_str(),
+                                     values.attribute->type());
+          CopyAttributeRange(*values.attribute, proto * attr.elementSize,
+                             (proto + 1) * attr.elementSize, *toAttr);
+        }
+      }
+
+      /*! Apply the per instance attributes and transform of the instancer to an
+       * instance object. The attributes of the nested instances the object was
+       * added for are applied first, so the outer instancers override them.
+       */
+      void ConvertInstanceOverrides(
+          GeometryList& out, const int obj, const size_t proto,
+          const ColorUvSpans& instanceData,
+          const std::vector<InstancerAttribute>& instancerAttributes,
+          const std::vector<NestedInstance>& nestedInstances,
+          const GfMatrix4d& transform)
+      {
+        for(const NestedInstance& nested : nestedInstances) {
+          ConvertColorUvs(
+              out, obj, ColorUvSpans(nested.overrides->colorUvs, nested.instance));
+          CopyInstanceAttributes(out, obj, nested.instance,
+                                 nested.overrides->attributes);
+        }
+        // Apply the attributes that the instancer overrides
+        ConvertColorUvs(out, obj, instanceData);
+        CopyInstanceAttributes(out, obj, proto, instancerAttributes);
+        ConvertObjectTransform(out, obj, transform);
+      }
+
+      /*! Convert the geometry and attributes of a prototype prim without adding it
+       * to the geometry list
+       * \return False if the prim type can't be converted this way
+       */
+      bool ConvertPrototype(const UsdPrim& prim,
+                            const UsdAttributeVector& instanceAttributes,
+                            const ConversionContext& ctx,
+                            PrototypeTemplate* proto)
+      {
+        if(prim.IsA<UsdGeomMesh>()) {
+          const UsdGeomMesh mesh(prim);
+          ConvertPoints(proto->points, mesh, ctx);
+          proto->primitive = convertUsdPrim<UsdGeomMesh, PolyMesh>(mesh, ctx.time);
+        }
+        else if(prim.IsA<UsdGeomPoints>()) {
+          const size_t nPoints =
+              ConvertPoints(proto->points, UsdGeomPoints(prim), ctx);
+          const float pointSize = 1.0f;
+          proto->primitive.reset(MakeRenderParticles(
+              Point::PARTICLE, static_cast<int>(nPoints), 0, false, pointSize));
+          proto->clearMaterial = true;
+        }
+        else if(prim.IsA<UsdGeomCube>()) {
+          double edgeLength = 0.0;
+          UsdGeomCube(prim).GetSizeAttr().Get(&edgeLength, ctx.time);
+          for(const auto& p : cubeGetPoints(edgeLength)) {
+            proto->points.emplace_back(p[0], p[1], p[2]);
+          }
+          proto->primitive = createCubeBase();
+        }
+        else {
+          return false;
+        }
+
+        proto->attributes = ConvertUsdAttributes(instanceAttributes, ctx);
+        bool resetsXFormStack;
+        UsdGeomXformable(prim).GetLocalTransformation(
+            &proto->local, &resetsXFormStack, ctx.time);
+        return true;
+      }
+
+      /// Add a copy of a converted prototype to the geometry list
+      int AddPrototypeInstance(GeometryList& out, const PrototypeTemplate& proto)
+      {
+        const int obj = out.size();
+        out.add_object(obj);
+        PointList* toPoints = out.writable_points(obj);
+        toPoints->assign(proto.points.begin(), proto.points.end());
+        // The geometry op will delete the prim
+        out.add_primitive(obj, proto.primitive->duplicate());
+        if(proto.clearMaterial) {
+          out[obj].material = nullptr;
+        }
+        for(const auto& attr : proto.attributes) {
+          Attribute* toAttr = out.writable_attribute(
+              obj, attr.group, attr.name.c_str(), attr.attribute->type());
+          CopyAttributeElements(*attr.attribute, nullptr, *toAttr);
+        }
+        return obj;
+      }
+
+      /*! Split the convertible attributes of an instancer that pass the attribute
+       * filter into those applied to all instances, and those with elementSize
+       * values per instance
+       */
+      void SplitInstancerAttributes(
+          const UsdGeomPointInstancer& instancer, const ConversionContext& ctx,
+          std::vector<UsdAttribute>* primAttributes,
+          std::vector<UsdAttribute>* constantAttributes,
+          std::vector<UsdAttribute>* elementWiseAttributes)
+      {
+        *primAttributes =
+            ctx.filterAttributes(ConvertibleAttributes(instancer.GetPrim()));
+        for(const auto& pAttribute : *primAttributes) {
+          TfToken interpolation = UsdGeomPrimvar(pAttribute).GetInterpolation();
+          if(interpolation == UsdGeomTokens->constant ||
+             interpolation == UsdGeomTokens->uniform) {
+            constantAttributes->push_back(pAttribute);
+          }
+          else if(elementWiseAttributes) {
+            elementWiseAttributes->push_back(pAttribute);
+          }
+        }
+      }
+
+      /*! Compute the instance transforms of an instancer, one per instance whether
+       * it is masked or not. When motion blur samples are set, the transforms at
+       * all the shutter times of the frame are computed in one call and kept by
+       * the cache for the following samples.
+       * \return False if the transforms couldn't be computed
+       */
+      bool ComputeInstanceTransforms(const UsdGeomPointInstancer& instancer,
+                                     const ConversionContext& ctx,
+                                     VtArray<GfMatrix4d>* xforms)
+      {
+        const UsdTimeCode time = ctx.time;
+        if(ctx.cache && ctx.options.instanceMotionSamples > 1 &&
+           time.IsNumeric()) {
+          const auto samples = ctx.cache->instanceTransforms(
+              instancer, ShutterTimes(time.GetValue(),
+                                      ctx.options.instanceMotionSamples,
+                                      ctx.options.instanceShutter));
+          const VtMatrix4dArray* sample =
+              samples ? samples->find(time.GetValue()) : nullptr;
+          if(sample) {
+            *xforms = *sample;
+            return true;
+          }
+        }
+        // Masked instances keep their transform, so the array lines up with the
+        // instance indices. The converters apply the mask themselves.
+        return instancer.ComputeInstanceTransformsAtTime(
+            xforms, time, time, UsdGeomPointInstancer::IncludeProtoXform,
+            UsdGeomPointInstancer::IgnoreMask);
+      }
+
+      /// Resolved prototypes of an instancer, shared with earlier loads when a cache is kept
+      std::shared_ptr<const InstancerPrototypes> ResolvePrototypes(
+          const UsdGeomPointInstancer& instancer, const ConversionContext& ctx)
+      {
+        if(ctx.cache) {
+          return ctx.cache->instancerPrototypes(instancer);
+        }
+        auto prototypes = std::make_shared<InstancerPrototypes>();
+        ReadInstancerPrototypes(instancer, prototypes.get());
+        return prototypes;
+      }
+
+      /// A converted prim added for every instance, with its transform relative to the instancer
+      struct PrototypeLeaf
+      {
+        const PrototypeTemplate* prototype = nullptr;
+        GfMatrix4d transform{1.0};
+        /// The prim is part of the instancer's prototype, not of a nested instancer
+        bool direct = true;
+        /// Instances of the nested instancers the prim was added for, innermost first
+        std::vector<NestedInstance> nestedInstances;
+      };
+
+      /*! The converted prims of the prototypes of an instancer, with nested
+       * instancers flattened into their leaf prims. Every prim is converted once
+       * per instancer evaluation, however many instances use it.
+       */
+      class PrototypeLeaves
+      {
+       public:
+        explicit PrototypeLeaves(const ConversionContext& ctx) : _ctx(ctx) {}
+
+        /*! Get the leaves of a prototype of an instancer, converting them on first use
+         * \param instancer           Instancer the prototype belongs to
+         * \param prototypes          Resolved prototypes of the instancer
+         * \param protoIndex          Index of the prototype
+         * \param primAttributes      Authored attributes of the instancer
+         * \param constantAttributes  Attributes the instancer sets for all instances
+         * \return The leaves, in prototype traversal order
+         */
+        const std::vector<PrototypeLeaf>& get(
+            const UsdGeomPointInstancer& instancer,
+            const InstancerPrototypes& prototypes, const size_t protoIndex,
+            const std::vector<UsdAttribute>& primAttributes,
+            const std::vector<UsdAttribute>& constantAttributes)
+        {
+          const auto key = std::make_pair(instancer.GetPath(), protoIndex);
+          const auto it = _prototypes.find(key);
+          if(it != _prototypes.end()) {
+            return it->second;
+          }
+
+          std::vector<PrototypeLeaf> leaves;
+          for(const auto& prim : prototypes.prims[protoIndex]) {
+            if(prim.IsA<UsdGeomPointInstancer>()) {
+              const std::vector<PrototypeLeaf>& nestedLeaves =
+                  nested(UsdGeomPointInstancer(prim));
+              leaves.insert(leaves.end(), nestedLeaves.begin(),
+                            nestedLeaves.end());
+              continue;
+            }
+            const std::shared_ptr<const PrototypeTemplate> converted =
+                convert(instancer, prim, primAttributes, constantAttributes);
+            // Prims that aren't geometry add nothing
+            if(converted) {
+              PrototypeLeaf leaf;
+              leaf.prototype = converted.get();
+              leaves.push_back(leaf);
+              _templates.push_back(converted);
+            }
+          }
+          return _prototypes.emplace(key, std::move(leaves)).first->second;
+        }
+
+       private:
+        /// Convert a prototype prim, or reuse the conversion of an earlier load if nothing changed
+        std::shared_ptr<const PrototypeTemplate> convert(
+            const UsdGeomPointInstancer& instancer, const UsdPrim& prim,
+            const std::vector<UsdAttribute>& primAttributes,
+            const std::vector<UsdAttribute>& constantAttributes)
+        {
+          const UsdAttributeVector instanceAttributes = _ctx.filterAttributes(
+              InstanceAttributes(_ctx, prim, primAttributes, constantAttributes));
+          size_t fingerprint = 0;
+          std::shared_ptr<const PrototypeTemplate> kept;
+          if(_ctx.cache) {
+            fingerprint = PrototypeFingerprint(prim, instanceAttributes);
+            kept = _ctx.cache->prototypeTemplate(instancer.GetPath(),
+                                                 prim.GetPath(), fingerprint);
+            if(kept && !kept->animated) {
+              return kept;
+            }
+          }
+          auto converted = std::make_shared<PrototypeTemplate>();
+          if(!ConvertPrototype(prim, instanceAttributes, _ctx, converted.get())) {
+            return nullptr;
+          }
+          if(_ctx.cache) {
+            // A kept template is only converted again if it is animated
+            converted->animated =
+                kept || PrototypeAnimated(prim, instanceAttributes);
+            _ctx.cache->setPrototypeTemplate(instancer.GetPath(), prim.GetPath(),
+                                             fingerprint, converted);
+          }
+          return converted;
+        }
+
+        /// Flatten a nested instancer into the leaves of all its instances
+        const std::vector<PrototypeLeaf>& nested(
+            const UsdGeomPointInstancer& instancer)
+        {
+          const SdfPath& path = instancer.GetPath();
+          const auto it = _nested.find(path);
+          if(it != _nested.end()) {
+            return it->second;
+          }
+          // An instancer that instances itself would never finish
+          if(!_active.insert(path).second) {
+            static const std::vector<PrototypeLeaf> kNoLeaves;
+            return kNoLeaves;
+          }
+
+          const UsdTimeCode time = _ctx.time;
+          VtIntArray protoIndices;
+          ComputePrimvar(protoIndices, instancer.GetProtoIndicesAttr(), time);
+          const std::shared_ptr<const InstancerPrototypes> prototypes =
+              ResolvePrototypes(instancer, _ctx);
+          const SdfPathVector& paths = prototypes->paths;
+          std::vector<UsdAttribute> primAttributes;
+          std::vector<UsdAttribute> constantAttributes;
+          std::vector<UsdAttribute> elementWiseAttributes;
+          SplitInstancerAttributes(instancer, _ctx, &primAttributes,
+                                   &constantAttributes, &elementWiseAttributes);
+          // The per instance attributes are applied to the leaves when they are added
+          auto overrides = std::make_unique<InstancerOverrides>();
+          overrides->attributes = ConvertInstancerAttributes(
+              ConvertMismatchedAttributes(overrides->colorUvs,
+                                          elementWiseAttributes, time, false,
+                                          _ctx.cache),
+              _ctx);
+          const InstancerOverrides* instanceOverrides = overrides.get();
+          _overrides.push_back(std::move(overrides));
+          VtArray<GfMatrix4d> xforms;
+          const bool pointInstancerTransforms =
+              ComputeInstanceTransforms(instancer, _ctx, &xforms);
+          const std::vector<bool> mask = instancer.ComputeMaskAtTime(time);
+
+          // Resolve the leaves of every instance, converting its prototype on first use
+          const size_t nInstances = protoIndices.size();
+          std::vector<const std::vector<PrototypeLeaf>*> instanceLeaves(
+              nInstances, nullptr);
+          std::vector<const std::vector<PrototypeLeaf>*> prototypeLeaves(
+              paths.size(), nullptr);
+          std::vector<size_t> offsets(nInstances + 1, 0);
+          for(size_t i = 0; i < nInstances; ++i) {
+            const int protoIndex = protoIndices[i];
+            offsets[i + 1] = offsets[i];
+            if((!mask.empty() && !mask[i]) || protoIndex < 0 ||
+               static_cast<size_t>(protoIndex) >= paths.size()) {
+              continue;
+            }
+            if(!prototypeLeaves[protoIndex]) {
+              prototypeLeaves[protoIndex] =
+                  &get(instancer, *prototypes, protoIndex, primAttributes,
+                       constantAttributes);
+            }
+            instanceLeaves[i] = prototypeLeaves[protoIndex];
+            offsets[i + 1] += instanceLeaves[i]->size();
+          }
+
+          // Compose the nested transforms of all the instances in bulk
+          std::vector<PrototypeLeaf> leaves(offsets.back());
+          const GfMatrix4d* xformData = xforms.cdata();
+          WorkParallelForN(nInstances, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; ++i) {
+              if(!instanceLeaves[i]) {
+                continue;
+              }
+              PrototypeLeaf* toLeaf = &leaves[offsets[i]];
+              for(const PrototypeLeaf& leaf : *instanceLeaves[i]) {
+                toLeaf->prototype = leaf.prototype;
+                toLeaf->direct = false;
+                toLeaf->nestedInstances = leaf.nestedInstances;
+                toLeaf->nestedInstances.push_back({instanceOverrides, i});
+                if(pointInstancerTransforms) {
+                  toLeaf->transform = leaf.transform * xformData[i];
+                }
+                else {
+                  toLeaf->transform =
+                      leaf.direct ? leaf.prototype->local : leaf.transform;
+                }
+                ++toLeaf;
+              }
+            }
+          });
+
+          _active.erase(path);
+          return _nested.emplace(path, std::move(leaves)).first->second;
+        }
+
+        const ConversionContext& _ctx;
+        /// Keeps the converted prototypes alive while the instances are added
+        std::vector<std::shared_ptr<const PrototypeTemplate>> _templates;
+        /// Element-wise data of the nested instancers, referenced by the leaves
+        std::vector<std::unique_ptr<const InstancerOverrides>> _overrides;
+        /// Keyed by instancer and prototype index, the map keeps references to its values valid
+        std::unordered_map<std::pair<SdfPath, size_t>, std::vector<PrototypeLeaf>,
+                           PathPairHash>
+            _prototypes;
+        std::unordered_map<SdfPath, std::vector<PrototypeLeaf>, SdfPath::Hash>
+            _nested;
+        /// Nested instancers being flattened
+        std::unordered_set<SdfPath, SdfPath::Hash> _active;
+      };
+
+      /// Display color and opacity of an instance, white if the instancer doesn't set them
+      Vector4 InstanceColor(const ColorUvData& instancerData, const size_t proto)
+      {
+        Vector4 color(1.0f, 1.0f, 1.0f, 1.0f);
+        const size_t c = proto * instancerData.colorElementSize;
+        if(c < instancerData.color.size()) {
+          const GfVec3f& rgb = instancerData.color[c];
+          color.set(rgb[0], rgb[1], rgb[2], 1.0f);
+        }
+        const size_t o = proto * instancerData.opacityElementSize;
+        if(o < instancerData.opacity.size()) {
+          color.w = instancerData.opacity[o];
+        }
+        return color;
+      }
+
+      /// Add one particle per instance, carrying the decomposed instance transforms
+      void AddInstancePoints(GeometryList& out, const int obj,
+                             const std::vector<size_t>& instances,
+                             const VtIntArray& protoIndices,
+                             const VtArray<GfMatrix4d>& xforms,
+                             const GfMatrix4d& worldMatrix,
+                             const ColorUvData& instancerData)
+      {
+        const size_t n = instances.size();
+        PointList& toPoints = *out.writable_points(obj);
+        toPoints.resize(n);
+        auto& orients =
+            *out.writable_attribute(obj, Group_Points, kOrientAttrName,
+                                    VECTOR4_ATTRIB)
+                 ->vector4_list;
+        auto& scales =
+            *out.writable_attribute(obj, Group_Points, kScaleAttrName,
+                                    VECTOR3_ATTRIB)
+                 ->vector3_list;
+        auto& indices =
+            *out.writable_attribute(obj, Group_Points, kProtoIndexAttrName,
+                                    INT_ATTRIB)
+                 ->int_list;
+        decltype(Attribute::vector4_list) colors = nullptr;
+        if(!instancerData.color.empty() || !instancerData.opacity.empty()) {
+          colors = out.writable_attribute(obj, Group_Points, kColorAttrName,
+                                          VECTOR4_ATTRIB)
+                       ->vector4_list;
+          colors->resize(n);
+        }
+        orients.resize(n);
+        scales.resize(n);
+        indices.resize(n);
+
+        WorkParallelForN(n, [&](size_t begin, size_t end) {
+          for(size_t i = begin; i < end; ++i) {
+            const size_t proto = instances[i];
+            const GfTransform transform(xforms[proto] * worldMatrix);
+            const GfVec3d& position = transform.GetTranslation();
+            const GfVec3d& scale = transform.GetScale();
+            const GfQuatd orient = transform.GetRotation().GetQuat();
+            const GfVec3d& imaginary = orient.GetImaginary();
+            toPoints[i].set(static_cast<float>(position[0]),
+                            static_cast<float>(position[1]),
+                            static_cast<float>(position[2]));
+            scales[i].set(static_cast<float>(scale[0]),
+                          static_cast<float>(scale[1]),
+                          static_cast<float>(scale[2]));
+            orients[i].set(static_cast<float>(imaginary[0]),
+                           static_cast<float>(imaginary[1]),
+                           static_cast<float>(imaginary[2]),
+                           static_cast<float>(orient.GetReal()));
+            indices[i] = protoIndices[proto];
+            if(colors) {
+              (*colors)[i] = InstanceColor(instancerData, proto);
+            }
+          }
+        });
+
+        const float pointSize = 1.0f;
+        out.add_primitive(obj, MakeRenderParticles(Point::PARTICLE,
+                                                   static_cast<int>(n), 0,
+                                                   false, pointSize));
+        out[obj].material = nullptr;
+      }
+
+      /// Add one box per instance, the size of the bounds of its prototype
+      void AddInstanceBoxes(GeometryList& out, const int obj,
+                            const UsdGeomPointInstancer& fromPrim,
+                            const SdfPathVector& paths,
+                            const std::vector<size_t>& instances,
+                            const VtIntArray& protoIndices,
+                            const VtArray<GfMatrix4d>& xforms,
+                            const GfMatrix4d& worldMatrix,
+                            const ColorUvData& instancerData,
+                            const UsdTimeCode time)
+      {
+        // Only the bounds of the prototypes are read, they aren't converted
+        const std::vector<GfBBox3d> prototypeBounds =
+            PrototypeBounds(fromPrim, paths, time);
+        std::vector<GfRange3d> bounds(paths.size());
+        for(size_t p = 0; p < paths.size(); ++p) {
+          bounds[p] = prototypeBounds[p].ComputeAlignedRange();
+          if(bounds[p].IsEmpty()) {
+            bounds[p] = GfRange3d(GfVec3d(-0.5), GfVec3d(0.5));
+          }
+        }
+
+        const size_t nCorners = 8;
+        const size_t n = instances.size();
+        PointList& toPoints = *out.writable_points(obj);
+        toPoints.resize(n * nCorners);
+        auto& indices =
+            *out.writable_attribute(obj, Group_Points, kProtoIndexAttrName,
+                                    INT_ATTRIB)
+                 ->int_list;
+        indices.resize(n * nCorners);
+        decltype(Attribute::vector4_list) colors = nullptr;
+        if(!instancerData.color.empty() || !instancerData.opacity.empty()) {
+          colors = out.writable_attribute(obj, Group_Points, kColorAttrName,
+                                          VECTOR4_ATTRIB)
+                       ->vector4_list;
+          colors->resize(n * nCorners);
+        }
+
+        WorkParallelForN(n, [&](size_t begin, size_t end) {
+          for(size_t i = begin; i < end; ++i) {
+            const size_t proto = instances[i];
+            const int protoIndex = protoIndices[proto];
+            const GfMatrix4d transform = xforms[proto] * worldMatrix;
+            const GfRange3d& range = bounds[protoIndex];
+            const Vector4 color =
+                colors ? InstanceColor(instancerData, proto) : Vector4();
+            // Corners in the order of the cube points
+            for(size_t c = 0; c < nCorners; ++c) {
+              const GfVec3d corner(
+                  (c & 1) ? range.GetMax()[0] : range.GetMin()[0],
+                  (c & 2) ? range.GetMin()[1] : range.GetMax()[1],
+                  (c & 4) ? range.GetMin()[2] : range.GetMax()[2]);
+              const GfVec3d p = transform.Transform(corner);
+              const size_t point = i * nCorners + c;
+              toPoints[point].set(static_cast<float>(p[0]),
+                                  static_cast<float>(p[1]),
+                                  static_cast<float>(p[2]));
+              indices[point] = protoIndex;
+              if(colors) {
+                (*colors)[point] = color;
+              }
+            }
+          }
+        });
+
+        auto boxes = std::make_unique<PolyMesh>(
+            n * cubeFaceVertexIndices.size(), n * cubeFaceVertexCounts.size());
+        std::vector<int> faceIndices(cubeFaceVertexIndices.size());
+        for(size_t i = 0; i < n; ++i) {
+          const int first = static_cast<int>(i * nCorners);
+          for(size_t v = 0; v < faceIndices.size(); ++v) {
+            faceIndices[v] = first + cubeFaceVertexIndices[v];
+          }
+          int point = 0;
+          for(size_t face = 0; face < cubeFaceVertexCounts.size();
+              point += cubeFaceVertexCounts[face], ++face) {
+            boxes->add_face(cubeFaceVertexCounts[face], &faceIndices[point],
+                            true);
+          }
+        }
+        out.add_primitive(obj, boxes.release());
+      }
+
+      /*! Add the visible instances of an instancer over the instance threshold as
+       * one proxy object in world space
+       * \return Index of the object
+       */
+      int AddInstancerProxy(GeometryList& out,
+                            const UsdGeomPointInstancer& fromPrim,
+                            const SdfPathVector& paths,
+                            const VtIntArray& protoIndices,
+                            const VtArray<GfMatrix4d>& xforms,
+                            const ColorUvData& instancerData,
+                            const ConversionContext& ctx)
+      {
+        const std::vector<bool> mask = fromPrim.ComputeMaskAtTime(ctx.time);
+        const GfMatrix4d worldMatrix = ctx.worldTransform(fromPrim.GetPrim());
+        const std::vector<GfBBox3d> cropBounds =
+            ctx.options.crop ? PrototypeBounds(fromPrim, paths, ctx.time)
+                             : std::vector<GfBBox3d>();
+        std::vector<size_t> instances;
+        instances.reserve(protoIndices.size());
+        for(size_t proto = 0; proto < protoIndices.size(); ++proto) {
+          const int protoIndex = protoIndices[proto];
+          if((mask.empty() || mask[proto]) && protoIndex >= 0 &&
+             static_cast<size_t>(protoIndex) < paths.size() &&
+             (cropBounds.empty() ||
+              InCropBox(cropBounds[protoIndex], xforms[proto] * worldMatrix,
+                        ctx.options.cropBox))) {
+            instances.push_back(proto);
+          }
+        }
+
+        const int obj = out.size();
+        out.add_object(obj);
+        if(ctx.options.instanceProxy == InstanceProxy::Boxes) {
+          AddInstanceBoxes(out, obj, fromPrim, paths, instances, protoIndices,
+                           xforms, worldMatrix, instancerData, ctx.time);
+        }
+        else {
+          AddInstancePoints(out, obj, instances, protoIndices, xforms,
+                            worldMatrix, instancerData);
+        }
+        ConvertPrimPath(out, obj, fromPrim.GetPrim());
+        // The points are already in world space
+        ConvertObjectTransform(out, obj, GfMatrix4d(1.0));
+        return obj;
+      }
+    }  // namespace
+
+    // Add UsdGeomPointInstancer to Nuke geometry list
+    int addUsdPrim(GeometryList& out, const UsdGeomPointInstancer& fromPrim,
+                   const ConversionContext& ctx)
+    {
+      const UsdTimeCode time = ctx.time;
+
+      UsdAttribute a_protoIndicies = fromPrim.GetProtoIndicesAttr();
+      VtIntArray protoIndices;
+      ComputePrimvar(protoIndices, a_protoIndicies, time);
+
+      // The prototype prims are resolved once, and kept across frames by the cache
+      const std::shared_ptr<const InstancerPrototypes> prototypes =
+          ResolvePrototypes(fromPrim, ctx);
+      const SdfPathVector& paths = prototypes->paths;
+
+      VtArray<GfMatrix4d> xforms;
+      const bool pointInstancerTransforms =
+          ComputeInstanceTransforms(fromPrim, ctx, &xforms);
+
+      // Split the attributes into those that need to be applied for all instances, and those that elementSize offsets
+      std::vector<UsdAttribute> primAttributes;
+      std::vector<UsdAttribute> constantAttributes;
+      std::vector<UsdAttribute> elementWiseAttributes;
+      SplitInstancerAttributes(fromPrim, ctx, &primAttributes,
+                               &constantAttributes, &elementWiseAttributes);
+      ColorUvData instancerData;
+      UsdAttributeVector remainingAttributes = ConvertMismatchedAttributes(
+          instancerData, elementWiseAttributes, time, false, ctx.cache);
+
+      // Massive instancers are drawn as a proxy built from the instancer's arrays
+      const size_t threshold = ctx.options.instanceThreshold;
+      if(threshold > 0 && protoIndices.size() > threshold &&
+         pointInstancerTransforms) {
+        // The proxy is already named and in world space
+        AddInstancerProxy(out, fromPrim, paths, protoIndices, xforms,
+                          instancerData, ctx);
+        return -1;
+      }
+
+      const std::vector<InstancerAttribute> instancerAttributes =
+          ConvertInstancerAttributes(remainingAttributes, ctx);
+
+      // Everything an instance needs that doesn't touch the geometry list is
+      // computed in parallel up front, then the instances are added in order
+      const size_t nInstances = protoIndices.size();
+      const std::vector<bool> maskedPrototypes = fromPrim.ComputeMaskAtTime(time);
+      const GfMatrix4d worldMatrix = ctx.worldTransform(fromPrim.GetPrim());
+      // Instances outside the crop box are dropped before their prototypes are converted
+      const std::vector<GfBBox3d> cropBounds =
+          ctx.options.crop && pointInstancerTransforms
+              ? PrototypeBounds(fromPrim, paths, time)
+              : std::vector<GfBBox3d>();
+      // Detach the array once, so the threads only write to their own elements
+      const size_t nXforms = xforms.size();
+      GfMatrix4d* xformData = xforms.data();
+      // Visible instances with a valid prototype
+      std::vector<char> validInstances(nInstances, 0);
+      std::vector<ColorUvSpans> instanceData(nInstances);
+      WorkParallelForN(
+          std::max(nInstances, nXforms), [&](size_t begin, size_t end) {
+            for(size_t proto = begin; proto < end; ++proto) {
+              // Move xforms from local coordinates to world coordinates
+              if(proto < nXforms) {
+                xformData[proto] *= worldMatrix;
+              }
+              if(proto >= nInstances ||
+                 (!maskedPrototypes.empty() && !maskedPrototypes[proto])) {
+                continue;
+              }
+              const int protoIndex = protoIndices[proto];
+              if(protoIndex < 0 ||
+                 static_cast<size_t>(protoIndex) >= paths.size()) {
+                continue;
+              }
+              if(!cropBounds.empty() && proto < nXforms &&
+                 !InCropBox(cropBounds[protoIndex], xformData[proto],
+                            ctx.options.cropBox)) {
+                continue;
+              }
+              validInstances[proto] = 1;
+              instanceData[proto] = ColorUvSpans(instancerData, proto);
+            }
+          });
+
+      // Convert the prototypes in order of first use, with nested instancers
+      // flattened, and count the objects each instance adds
+      PrototypeLeaves prototypeLeaves(ctx);
+      std::vector<const std::vector<PrototypeLeaf>*> leaves(paths.size(),
+                                                            nullptr);
+      std::vector<size_t> offsets(nInstances + 1, 0);
+      for(size_t proto = 0; proto < nInstances; ++proto) {
+        offsets[proto + 1] = offsets[proto];
+        if(!validInstances[proto]) {
+          continue;
+        }
+        const int protoIndex = protoIndices[proto];
+        if(!leaves[protoIndex]) {
+          leaves[protoIndex] =
+              &prototypeLeaves.get(fromPrim, *prototypes, protoIndex,
+                                   primAttributes, constantAttributes);
+        }
+        offsets[proto + 1] += leaves[protoIndex]->size();
+      }
+
+      // Compose the final transforms of all the objects
+      std::vector<GfMatrix4d> transforms(offsets.back());
+      WorkParallelForN(nInstances, [&](size_t begin, size_t end) {
+        for(size_t proto = begin; proto < end; ++proto) {
+          if(!validInstances[proto]) {
+            continue;
+          }
+          GfMatrix4d* toTransform = &transforms[offsets[proto]];
+          for(const PrototypeLeaf& leaf : *leaves[protoIndices[proto]]) {
+            if(pointInstancerTransforms) {
+              *toTransform = leaf.transform * xformData[proto];
+            }
+            else {
+              *toTransform = leaf.direct ? leaf.prototype->local : leaf.transform;
+            }
+            ++toTransform;
+          }
+        }
+      });
+
+      // Add the objects in instance order
+      for(size_t proto = 0; proto < nInstances; ++proto) {
+        if(!validInstances[proto]) {
+          continue;
+        }
+        const GfMatrix4d* transform = &transforms[offsets[proto]];
+        for(const PrototypeLeaf& leaf : *leaves[protoIndices[proto]]) {
+          const int obj = AddPrototypeInstance(out, *leaf.prototype);
+          ConvertInstanceOverrides(out, obj, proto, instanceData[proto],
+                                   instancerAttributes, leaf.nestedInstances,
+                                   *transform++);
+        }
+      }
+
+      return -1;
+    }
+
     template <>
-    FN_USDCONVERTER_API int addUsdPrim<UsdGeomCube>(GeometryList& out,
-                                                    const UsdGeomCube& fromPrim,
-                                                    const UsdTimeCode /* unused */)
+    FN_USDCONVERTER_API int addUsdPrim<UsdGeomPointInstancer>(
+        GeometryList& out, const UsdGeomPointInstancer& fromPrim,
+        const UsdTimeCode time)
+    {
+      return addUsdPrim(out, fromPrim, ConversionContext(time));
+    }
+
+    // Add UsdGeomCube to Nuke geometry list
+    int addUsdPrim(GeometryList& out, const UsdGeomCube& fromPrim,
+                   const ConversionContext& ctx)
     {
       // Create the cube's Nuke mesh object
       std::unique_ptr<PolyMesh> cubeMesh = createCubeBase();
@@ -349,7 +1217,7 @@ namespace Foundry
       // Retrieve USD cube's edge length and generate the points with that length
       double edgeLength = 0.0;
       const UsdAttribute edgeLengthAttr = fromPrim.GetSizeAttr();
-      edgeLengthAttr.Get(&edgeLength);
+      edgeLengthAttr.Get(&edgeLength, ctx.time);
       const VtArray<GfVec3f> points = cubeGetPoints(edgeLength);
 
       PointList* toPoints = out.writable_points(obj);
@@ -363,21 +1231,29 @@ namespace Foundry
       return obj;
     }
 
+    template <>
+    FN_USDCONVERTER_API int addUsdPrim<UsdGeomCube>(GeometryList& out,
+                                                    const UsdGeomCube& fromPrim,
+                                                    const UsdTimeCode time)
+    {
+      return addUsdPrim(out, fromPrim, ConversionContext(time));
+    }
+
     int addUsdPrim(GeometryList& out, const UsdPrim& prim,
-                   const UsdTimeCode time)
+                   const ConversionContext& ctx)
     {
       // Identify the USD prim type and if supported convert it to Nuke geometry
       if(prim.IsA<UsdGeomMesh>()) {
-        return addUsdPrim(out, UsdGeomMesh(prim), time);
+        return addUsdPrim(out, UsdGeomMesh(prim), ctx);
       }
       else if(prim.IsA<UsdGeomPoints>()) {
-        return addUsdPrim(out, UsdGeomPoints(prim), time);
+        return addUsdPrim(out, UsdGeomPoints(prim), ctx);
       }
       else if(prim.IsA<UsdGeomCube>()) {
-        return addUsdPrim(out, UsdGeomCube(prim), time);
+        return addUsdPrim(out, UsdGeomCube(prim), ctx);
       }
       else if(prim.IsA<UsdGeomPointInstancer>()) {
-        return addUsdPrim(out, UsdGeomPointInstancer(prim), time);
+        return addUsdPrim(out, UsdGeomPointInstancer(prim), ctx);
       }
       return -1;
     }
@@ -407,28 +1283,88 @@ namespace Foundry
       return getPrimitiveData(stage, types);
     }
 
+    namespace
+    {
+      /// Faces at which a merged object of small meshes is full, when meshes aren't split
+      const size_t kMaxMergedFaces = 1 << 16;
+    }  // namespace
+
     FN_USDCONVERTER_API void convertUsdGeometry(GeometryList& out,
                                                 UsdStageRefPtr stage,
-                                                UsdTimeCode time)
+                                                UsdTimeCode time,
+                                                ConversionCache* cache,
+                                                const ConversionOptions& options)
     {
-      // Traverse the stage at the required timecode and convert all loaded USD prims to Nuke geometry
-      UsdGeomXformCache cache;
-      cache.SetTime(time);
+      // Compute the world transforms and inherited primvars once, so all converters share them
+      const PrimHierarchy hierarchy(stage);
+      const WorldTransforms transforms(hierarchy, UsdGeomGetStageUpAxis(stage),
+                                       time);
+      const InheritedPrimvars inheritedPrimvars(hierarchy);
+      ConversionContext ctx(time);
+      ctx.transforms = &transforms;
+      ctx.inheritedPrimvars = &inheritedPrimvars;
+      ctx.cache = cache;
+      ctx.options = options;
+      if(!options.attributeInclude.empty() || !options.attributeExclude.empty()) {
+        ctx.attributeFilter = std::make_shared<const AttributeFilter>(
+            options.attributeInclude, options.attributeExclude);
+      }
 
-      const TfToken upAxis = UsdGeomGetStageUpAxis(stage);
+      // Merged objects are kept below the split size, so merging never undoes splitting
+      MeshBatches batches(options.mergeFaceCount,
+                          options.splitFaceCount > 0 ? options.splitFaceCount
+                                                     : kMaxMergedFaces);
 
-      for(const auto& prim : stage->Traverse()) {
-        const int obj = addUsdPrim(out, prim, time);
+      // Bounds of the prims tested against the crop box, from their authored extents where they exist
+      std::unique_ptr<UsdGeomBBoxCache> bboxCache;
+      if(options.crop) {
+        bboxCache = std::make_unique<UsdGeomBBoxCache>(
+            time, TfTokenVector{UsdGeomTokens->default_});
+      }
+
+      // Convert all loaded USD prims to Nuke geometry, in traversal order
+      for(size_t i = 0; i < hierarchy.size(); ++i) {
+        const UsdPrim& prim = hierarchy.prim(i);
+        // Instancers are cropped per instance instead
+        if(bboxCache && !prim.IsA<UsdGeomPointInstancer>() &&
+           prim.IsA<UsdGeomBoundable>() &&
+           !InCropBox(bboxCache->ComputeUntransformedBound(prim),
+                      transforms.at(i), options.cropBox)) {
+          continue;
+        }
+        if(options.mergeFaceCount > 0 && prim.IsA<UsdGeomMesh>() &&
+           batches.add(UsdGeomMesh(prim), transforms.at(i), ctx)) {
+          continue;
+        }
+        if(options.splitFaceCount > 0 && prim.IsA<UsdGeomMesh>()) {
+          const int first = AddMeshChunks(out, UsdGeomMesh(prim), ctx);
+          if(first != -1) {
+            const bool split = out.size() - first > 1;
+            for(int obj = first; obj < out.size(); ++obj) {
+              if(split) {
+                ConvertPrimPath(out, obj, prim, obj - first);
+              }
+              else {
+                ConvertPrimPath(out, obj, prim);
+              }
+              ConvertObjectTransform(out, obj, transforms.at(i));
+            }
+            continue;
+          }
+        }
+
+        const int obj = addUsdPrim(out, prim, ctx);
         if(obj == -1) {
           continue;
         }
         // If the prim type was recognized translate its attributes
-        ConvertUsdAttributes(out, obj, prim.GetAttributes(), time);
+        ConvertUsdAttributes(out, obj,
+                             ctx.filterAttributes(ctx.primAttributes(prim)),
+                             ctx);
         ConvertPrimPath(out, obj, prim);
-        GfMatrix4d world = cache.GetLocalToWorldTransform(prim);
-        ApplyUpAxisRotation(world, upAxis);
-        ConvertObjectTransform(out, obj, world);
+        ConvertObjectTransform(out, obj, transforms.at(i));
       }
+      batches.addObjects(out);
     }
   }  // namespace UsdConverter
 }  // namespace Foundry
@@ -0,0 +1,127 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Implementation file for UsdConverter decoding of half float arrays
+ */
+
+#include "UsdConverter/UsdHalfFloats.h"
+
+#include <pxr/base/work/loops.h>
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define USD_CONVERTER_F16C_TARGET
+#else
+// Only the decoding functions are built for F16C, the CPU is checked before they are called
+#define USD_CONVERTER_F16C_TARGET __attribute__((target("avx,f16c")))
+#endif
+#define USD_CONVERTER_F16C 1
+#endif
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    namespace
+    {
+      /// Arrays with fewer halves than this are not worth splitting across threads
+      const size_t kParallelThreshold = 1 << 16;
+
+      /// out = from over [begin, end), one half at a time through USD's lookup table
+      void DecodeRange(const GfHalf* from, size_t begin, size_t end, float* out)
+      {
+        for(size_t i = begin; i < end; ++i) {
+          out[i] = static_cast<float>(from[i]);
+        }
+      }
+
+#ifdef USD_CONVERTER_F16C
+      USD_CONVERTER_F16C_TARGET void DecodeRangeF16C(const GfHalf* from,
+                                                     size_t begin, size_t end,
+                                                     float* out)
+      {
+        static_assert(sizeof(GfHalf) == sizeof(uint16_t),
+                      "Halves are decoded from their 16 bits");
+        size_t i = begin;
+        for(; i + 8 <= end; i += 8) {
+          const __m128i h =
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+          _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+        }
+        // The remaining tail
+        DecodeRange(from, i, end, out);
+      }
+
+      bool DetectF16C()
+      {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        const bool f16c = (info[2] & (1 << 29)) != 0;
+        // The operating system has to save the AVX registers too
+        return osxsave && avx && f16c && (_xgetbv(0) & 0x6) == 0x6;
+#else
+        return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+      }
+#endif
+    }  // namespace
+
+    bool HasHalfDecodeInstructions()
+    {
+#ifdef USD_CONVERTER_F16C
+      static const bool hasF16C = DetectF16C();
+      return hasF16C;
+#else
+      return false;
+#endif
+    }
+
+    void DecodeHalfs(const GfHalf* from, size_t count, float* out)
+    {
+      void (*decode)(const GfHalf*, size_t, size_t, float*) = &DecodeRange;
+#ifdef USD_CONVERTER_F16C
+      if(HasHalfDecodeInstructions()) {
+        decode = &DecodeRangeF16C;
+      }
+#endif
+      if(count < kParallelThreshold) {
+        decode(from, 0, count, out);
+      }
+      else {
+        WorkParallelForN(count, [&](size_t begin, size_t end) {
+          decode(from, begin, end, out);
+        });
+      }
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
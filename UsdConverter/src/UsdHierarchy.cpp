@@ -0,0 +1,242 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Implementation file for UsdConverter stage hierarchy passes
+ */
+
+#include "UsdConverter/UsdHierarchy.h"
+
+#include "UsdConverter/UsdCommon.h"
+
+#include <pxr/base/work/loops.h>
+#include <pxr/usd/usd/primRange.h>
+#include <pxr/usd/usdGeom/cube.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/usd/usdGeom/metrics.h>
+#include <pxr/usd/usdGeom/pointInstancer.h>
+#include <pxr/usd/usdGeom/points.h>
+#include <pxr/usd/usdGeom/primvarsAPI.h>
+#include <pxr/usd/usdGeom/xformCache.h>
+#include <pxr/usd/usdGeom/xformable.h>
+
+#include <limits>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    const size_t PrimHierarchy::kNoParent = std::numeric_limits<size_t>::max();
+
+    PrimHierarchy::PrimHierarchy(const UsdStageRefPtr& stage)
+    {
+      // Depth of each prim, only needed while the levels are being built
+      std::vector<size_t> depths;
+
+      // Traverse in pre-order, so a prim's parent is always recorded before it
+      for(const auto& prim : stage->Traverse()) {
+        size_t parent = kNoParent;
+        size_t level = 0;
+        const auto it_parent = _indices.find(prim.GetPath().GetParentPath());
+        if(it_parent != _indices.cend()) {
+          parent = it_parent->second;
+          level = depths[parent] + 1;
+        }
+        const size_t index = _prims.size();
+        _prims.push_back(prim);
+        _parents.push_back(parent);
+        depths.push_back(level);
+        _indices.emplace(prim.GetPath(), index);
+        if(_levels.size() <= level) {
+          _levels.resize(level + 1);
+        }
+        _levels[level].push_back(index);
+      }
+    }
+
+    bool PrimHierarchy::find(const SdfPath& path, size_t* index) const
+    {
+      const auto it = _indices.find(path);
+      if(it == _indices.cend()) {
+        return false;
+      }
+      *index = it->second;
+      return true;
+    }
+
+    WorldTransforms::WorldTransforms(const PrimHierarchy& hierarchy,
+                                     const TfToken& upAxis,
+                                     UsdTimeCode time)
+        : _hierarchy(&hierarchy), _worlds(hierarchy.size())
+    {
+      // Fold the up-axis rotation into the root once instead of applying it to every result
+      GfMatrix4d root(1.0);
+      ApplyUpAxisRotation(root, upAxis);
+
+      for(const auto& level : hierarchy.levels()) {
+        WorkParallelForN(level.size(), [&](size_t begin, size_t end) {
+          for(size_t i = begin; i < end; ++i) {
+            const size_t index = level[i];
+            const size_t parent = hierarchy.parent(index);
+            const GfMatrix4d& parentWorld =
+                parent == PrimHierarchy::kNoParent ? root : _worlds[parent];
+
+            const UsdGeomXformable xformable(hierarchy.prim(index));
+            if(!xformable) {
+              // Prims that can't be transformed inherit their parent's transform
+              _worlds[index] = parentWorld;
+              continue;
+            }
+            GfMatrix4d local;
+            bool resetsXformStack = false;
+            xformable.GetLocalTransformation(&local, &resetsXformStack, time);
+            _worlds[index] = local * (resetsXformStack ? root : parentWorld);
+          }
+        });
+      }
+    }
+
+    bool WorldTransforms::get(const SdfPath& path, GfMatrix4d* world) const
+    {
+      size_t index;
+      if(!_hierarchy || !_hierarchy->find(path, &index)) {
+        return false;
+      }
+      *world = _worlds[index];
+      return true;
+    }
+
+    InheritedPrimvars::InheritedPrimvars(const PrimHierarchy& hierarchy)
+        : _hierarchy(&hierarchy), _inheritable(hierarchy.size())
+    {
+      static const Primvars kNone;
+      for(const auto& level : hierarchy.levels()) {
+        WorkParallelForN(level.size(), [&](size_t begin, size_t end) {
+          for(size_t i = begin; i < end; ++i) {
+            const size_t index = level[i];
+            const size_t parent = hierarchy.parent(index);
+            std::shared_ptr<const Primvars> fromParent;
+            if(parent != PrimHierarchy::kNoParent) {
+              fromParent = _inheritable[parent];
+            }
+
+            // Empty when the prim changes nothing, its children then share the parent's set
+            Primvars primvars =
+                UsdGeomPrimvarsAPI(hierarchy.prim(index))
+                    .FindIncrementallyInheritablePrimvars(
+                        fromParent ? *fromParent : kNone);
+            _inheritable[index] =
+                primvars.empty()
+                    ? fromParent
+                    : std::make_shared<const Primvars>(std::move(primvars));
+          }
+        });
+      }
+    }
+
+    void InheritedPrimvars::append(const UsdPrim& prim,
+                                   std::vector<UsdAttribute>* attrs) const
+    {
+      size_t index;
+      if(!_hierarchy || !_hierarchy->find(prim.GetPath(), &index)) {
+        return;
+      }
+      const size_t parent = _hierarchy->parent(index);
+      if(parent == PrimHierarchy::kNoParent || !_inheritable[parent]) {
+        return;
+      }
+      // The prim's own primvars override the inherited ones
+      TfToken::HashSet names;
+      for(const auto& attr : *attrs) {
+        names.insert(attr.GetName());
+      }
+      for(const auto& primvar : *_inheritable[parent]) {
+        if(names.count(primvar.GetName()) == 0) {
+          attrs->push_back(primvar.GetAttr());
+        }
+      }
+    }
+
+    GfMatrix4d ComputeWorldTransform(const UsdPrim& prim, UsdTimeCode time)
+    {
+      UsdGeomXformCache cache(time);
+      GfMatrix4d world = cache.GetLocalToWorldTransform(prim);
+      ApplyUpAxisRotation(world, UsdGeomGetStageUpAxis(prim.GetStage()));
+      return world;
+    }
+
+    namespace
+    {
+      bool MightBeTimeVarying(const UsdAttribute& attr)
+      {
+        return attr && attr.ValueMightBeTimeVarying();
+      }
+    }  // namespace
+
+    StageAnimation ComputeStageAnimation(const UsdStageRefPtr& stage)
+    {
+      StageAnimation animation;
+      for(const auto& prim : stage->Traverse()) {
+        if(prim.IsA<UsdGeomMesh>()) {
+          const UsdGeomMesh mesh(prim);
+          animation.topology =
+              animation.topology ||
+              MightBeTimeVarying(mesh.GetFaceVertexCountsAttr()) ||
+              MightBeTimeVarying(mesh.GetFaceVertexIndicesAttr());
+          animation.points =
+              animation.points || MightBeTimeVarying(mesh.GetPointsAttr());
+        }
+        else if(prim.IsA<UsdGeomPoints>()) {
+          // Every point is a particle, so their number can change too
+          animation.topology =
+              animation.topology ||
+              MightBeTimeVarying(UsdGeomPoints(prim).GetPointsAttr());
+        }
+        else if(prim.IsA<UsdGeomCube>()) {
+          // The points are built from the edge length
+          animation.points =
+              animation.points ||
+              MightBeTimeVarying(UsdGeomCube(prim).GetSizeAttr());
+        }
+        else if(prim.IsA<UsdGeomPointInstancer>()) {
+          const UsdGeomPointInstancer instancer(prim);
+          animation.topology =
+              animation.topology ||
+              MightBeTimeVarying(instancer.GetProtoIndicesAttr()) ||
+              MightBeTimeVarying(instancer.GetInvisibleIdsAttr()) ||
+              MightBeTimeVarying(instancer.GetIdsAttr());
+          animation.instances =
+              animation.instances ||
+              MightBeTimeVarying(instancer.GetPositionsAttr()) ||
+              MightBeTimeVarying(instancer.GetOrientationsAttr()) ||
+              MightBeTimeVarying(instancer.GetScalesAttr());
+        }
+        if(animation.topology && animation.points && animation.instances) {
+          break;
+        }
+      }
+      return animation;
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
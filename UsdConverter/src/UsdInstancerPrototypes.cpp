@@ -0,0 +1,105 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Implementation file for resolving the prototypes of point instancers
+ */
+
+#include "UsdConverter/UsdInstancerPrototypes.h"
+
+#include <pxr/usd/usd/relationship.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/usdGeom/cube.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/usd/usdGeom/points.h>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    namespace
+    {
+      /// Prim types an instance can add
+      bool IsConvertible(const UsdPrim& prim)
+      {
+        return prim.IsA<UsdGeomMesh>() || prim.IsA<UsdGeomPoints>() ||
+               prim.IsA<UsdGeomCube>() || prim.IsA<UsdGeomPointInstancer>();
+      }
+    }  // namespace
+
+    size_t PrototypeFingerprint(const UsdPrim& prim,
+                                const std::vector<UsdAttribute>& instanceAttributes)
+    {
+      size_t fingerprint = SdfPath::Hash()(prim.GetPath());
+      for(const auto& attribute : instanceAttributes) {
+        const size_t value = SdfPath::Hash()(attribute.GetPath());
+        fingerprint ^= value + 0x9e3779b9 + (fingerprint << 6) + (fingerprint >> 2);
+      }
+      return fingerprint;
+    }
+
+    bool PrototypeAnimated(const UsdPrim& prim,
+                           const std::vector<UsdAttribute>& instanceAttributes)
+    {
+      for(const auto& attribute : instanceAttributes) {
+        if(attribute.ValueMightBeTimeVarying()) {
+          return true;
+        }
+      }
+      // The points and topology are read from the prim's own attributes
+      for(const auto& attribute : prim.GetAttributes()) {
+        if(attribute.ValueMightBeTimeVarying()) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void ReadInstancerPrototypes(const UsdGeomPointInstancer& instancer,
+                                 InstancerPrototypes* prototypes)
+    {
+      instancer.GetPrototypesRel().GetForwardedTargets(&prototypes->paths);
+      prototypes->prims.assign(prototypes->paths.size(), {});
+
+      const UsdStageWeakPtr stage = instancer.GetPrim().GetStage();
+      for(size_t p = 0; p < prototypes->paths.size(); ++p) {
+        const UsdPrim root = stage->GetPrimAtPath(prototypes->paths[p]);
+        if(!root) {
+          continue;
+        }
+        std::vector<UsdPrim>& prims = prototypes->prims[p];
+        const auto allDescs = root.GetAllDescendants();
+        if(allDescs.empty()) {
+          prims.push_back(root);
+          continue;
+        }
+        for(const auto& prim : allDescs) {
+          if(IsConvertible(prim)) {
+            prims.push_back(prim);
+          }
+        }
+      }
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
@@ -0,0 +1,238 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Implementation file for merging small meshes into shared Nuke objects
+ */
+
+#include "UsdConverter/UsdMeshBatches.h"
+
+#include "UsdConverter/UsdConversionContext.h"
+
+#include <DDImage/Attribute.h>
+#include <DDImage/GeometryList.h>
+#include <DDImage/PolyMesh.h>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/usd/usdGeom/tokens.h>
+
+#include <algorithm>
+#include <memory>
+
+using namespace DD::Image;
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    namespace
+    {
+      Vector3 Transform(const GfMatrix4d& matrix, const Vector3& v)
+      {
+        const GfVec3d result = matrix.Transform(GfVec3d(v.x, v.y, v.z));
+        return Vector3(static_cast<float>(result[0]),
+                       static_cast<float>(result[1]),
+                       static_cast<float>(result[2]));
+      }
+
+      Vector3 TransformDir(const GfMatrix4d& matrix, const Vector3& v,
+                           bool normalize)
+      {
+        GfVec3d result = matrix.TransformDir(GfVec3d(v.x, v.y, v.z));
+        if(normalize) {
+          result.Normalize();
+        }
+        return Vector3(static_cast<float>(result[0]),
+                       static_cast<float>(result[1]),
+                       static_cast<float>(result[2]));
+      }
+
+      /// Move the directions of the attributes into world space along with the points
+      void BakeAttribute(const GfMatrix4d& world, const ConvertedAttribute& attr)
+      {
+        const AttribType type = attr.attribute->type();
+        if(type != VECTOR3_ATTRIB && type != NORMAL_ATTRIB) {
+          return;
+        }
+        if(attr.name == kNormalAttrName) {
+          const GfMatrix4d normalMatrix = world.GetInverse().GetTranspose();
+          for(auto& n : *attr.attribute->vector3_list) {
+            n = TransformDir(normalMatrix, n, true);
+          }
+        }
+        else if(attr.name == kVelocityAttrName) {
+          for(auto& v : *attr.attribute->vector3_list) {
+            v = TransformDir(world, v, false);
+          }
+        }
+      }
+    }  // namespace
+
+    MeshBatches::MeshBatches(size_t maxMeshFaces, size_t maxBatchFaces)
+        : _maxMeshFaces(maxMeshFaces), _maxBatchFaces(maxBatchFaces)
+    {
+    }
+
+    bool MeshBatches::add(const UsdGeomMesh& fromPrim, const GfMatrix4d& world,
+                          const ConversionContext& ctx)
+    {
+      Mesh mesh;
+      fromPrim.GetFaceVertexCountsAttr().Get(&mesh.faceVertexCounts, ctx.time);
+      const size_t faces = mesh.faceVertexCounts.size();
+      if(faces == 0 || faces > _maxMeshFaces) {
+        return false;
+      }
+
+      mesh.attributes = ConvertUsdAttributes(
+          ctx.filterAttributes(ctx.primAttributes(fromPrim.GetPrim())), ctx);
+      // Per face values have no place in an object with one primitive per mesh
+      if(std::any_of(mesh.attributes.cbegin(), mesh.attributes.cend(),
+                     [](const ConvertedAttribute& attr) {
+                       return attr.group == Group_Primitives;
+                     })) {
+        return false;
+      }
+      std::sort(mesh.attributes.begin(), mesh.attributes.end(),
+                [](const ConvertedAttribute& a, const ConvertedAttribute& b) {
+                  return a.name != b.name ? a.name < b.name : a.group < b.group;
+                });
+      // Only meshes whose attributes convert to the same names, groups and types can share an object
+      std::string layout;
+      for(const auto& attr : mesh.attributes) {
+        layout += attr.name + ":" + std::to_string(attr.group) + ":" +
+                  std::to_string(attr.attribute->type()) + ";";
+      }
+
+      ConvertPoints(mesh.points, fromPrim, ctx);
+      fromPrim.GetFaceVertexIndicesAttr().Get(&mesh.faceVertexIndices, ctx.time);
+      size_t vertices = 0;
+      for(const int count : mesh.faceVertexCounts) {
+        vertices += static_cast<size_t>(std::max(count, 0));
+      }
+      // Invalid topology is left to the regular conversion
+      if(vertices != mesh.faceVertexIndices.size() ||
+         std::any_of(mesh.faceVertexIndices.cbegin(),
+                     mesh.faceVertexIndices.cend(), [&](int index) {
+                       return index < 0 ||
+                              static_cast<size_t>(index) >= mesh.points.size();
+                     })) {
+        return false;
+      }
+
+      TfToken orientation;
+      fromPrim.GetOrientationAttr().Get(&orientation);
+      mesh.leftHanded = orientation == UsdGeomTokens->leftHanded;
+      mesh.path = fromPrim.GetPath().GetString();
+
+      for(auto& p : mesh.points) {
+        p = Transform(world, p);
+      }
+      for(const auto& attr : mesh.attributes) {
+        BakeAttribute(world, attr);
+      }
+
+      const auto it_open = _openBatches.find(layout);
+      size_t index;
+      if(it_open == _openBatches.end() ||
+         _batches[it_open->second].faces + faces > _maxBatchFaces) {
+        // Start a new batch once the open one is full
+        index = _batches.size();
+        _batches.emplace_back();
+        _openBatches[layout] = index;
+      }
+      else {
+        index = it_open->second;
+      }
+      Batch& batch = _batches[index];
+      batch.faces += faces;
+      batch.meshes.push_back(std::move(mesh));
+      return true;
+    }
+
+    void MeshBatches::addObjects(GeometryList& out) const
+    {
+      for(const auto& batch : _batches) {
+        const int obj = out.size();
+        out.add_object(obj);
+
+        PointList* toPoints = out.writable_points(obj);
+        size_t pointCount = 0;
+        for(const auto& mesh : batch.meshes) {
+          pointCount += mesh.points.size();
+        }
+        toPoints->clear();
+        toPoints->reserve(pointCount);
+
+        // One primitive per mesh, indexing its range of the shared points
+        std::vector<int> faceVertexIndices;
+        for(const auto& mesh : batch.meshes) {
+          const int offset = static_cast<int>(toPoints->size());
+          toPoints->insert(toPoints->end(), mesh.points.begin(),
+                           mesh.points.end());
+
+          faceVertexIndices.assign(mesh.faceVertexIndices.cbegin(),
+                                   mesh.faceVertexIndices.cend());
+          for(auto& index : faceVertexIndices) {
+            index += offset;
+          }
+          auto toMesh = std::make_unique<PolyMesh>(
+              faceVertexIndices.size(), mesh.faceVertexCounts.size());
+          int* vertices = faceVertexIndices.data();
+          for(const int count : mesh.faceVertexCounts) {
+            toMesh->add_face(count, vertices, mesh.leftHanded);
+            vertices += count;
+          }
+          // The geometry op will delete the prim
+          out.add_primitive(obj, toMesh.release());
+        }
+
+        const auto& layout = batch.meshes.front().attributes;
+        for(size_t a = 0; a < layout.size(); ++a) {
+          // Object values become one value per mesh primitive
+          const GroupType group = layout[a].group == Group_Object
+                                      ? Group_Primitives
+                                      : layout[a].group;
+          Attribute* toAttr = out.writable_attribute(
+              obj, group, layout[a].name.c_str(), layout[a].attribute->type());
+          toAttr->clear();
+          for(const auto& mesh : batch.meshes) {
+            AppendAttributeElements(*mesh.attributes[a].attribute, *toAttr);
+          }
+        }
+
+        Attribute* names = out.writable_attribute(
+            obj, Group_Primitives, kNameAttrName, STD_STRING_ATTRIB);
+        names->clear();
+        for(const auto& mesh : batch.meshes) {
+          names->std_string_list->push_back(mesh.path);
+        }
+
+        // The transforms are baked into the points
+        Attribute* transform = out.writable_attribute(
+            obj, Group_Object, kTransformAttrName, MATRIX4_ATTRIB);
+        transform->matrix4(0) = ConvertMatrix4(GfMatrix4d(1.0));
+      }
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
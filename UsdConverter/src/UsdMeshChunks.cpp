@@ -0,0 +1,162 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+
+/*! \file
+ \brief Implementation file for splitting large meshes into spatially coherent chunks
+ */
+
+#include "UsdConverter/UsdMeshChunks.h"
+
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    namespace
+    {
+      /// Face index ranges of the chunks, halving the faces until every range is small enough
+      std::vector<std::pair<size_t, size_t>> PartitionFaces(
+          std::vector<unsigned>& faces, const std::vector<GfVec3f>& centroids,
+          size_t maxFaces)
+      {
+        std::vector<std::pair<size_t, size_t>> chunks;
+        std::vector<std::pair<size_t, size_t>> pending{{0, faces.size()}};
+        while(!pending.empty()) {
+          const auto range = pending.back();
+          pending.pop_back();
+          if(range.second - range.first <= maxFaces) {
+            chunks.push_back(range);
+            continue;
+          }
+
+          GfRange3f bounds;
+          for(size_t i = range.first; i < range.second; ++i) {
+            bounds.UnionWith(centroids[faces[i]]);
+          }
+          const GfVec3f size = bounds.GetSize();
+          const int axis = size[0] >= size[1] ? (size[0] >= size[2] ? 0 : 2)
+                                               : (size[1] >= size[2] ? 1 : 2);
+
+          const size_t middle = range.first + (range.second - range.first) / 2;
+          std::nth_element(faces.begin() + range.first, faces.begin() + middle,
+                           faces.begin() + range.second,
+                           [&](unsigned a, unsigned b) {
+                             return centroids[a][axis] < centroids[b][axis];
+                           });
+          // Upper half first, so the chunks come out in the order of the split
+          pending.emplace_back(middle, range.second);
+          pending.emplace_back(range.first, middle);
+        }
+        return chunks;
+      }
+    }  // namespace
+
+    std::vector<MeshChunk> SplitMesh(const VtIntArray& faceVertexCounts,
+                                     const VtIntArray& faceVertexIndices,
+                                     const float* points, size_t pointCount,
+                                     size_t maxFaces)
+    {
+      const size_t faceCount = faceVertexCounts.size();
+      if(maxFaces == 0 || faceCount <= maxFaces) {
+        return {};
+      }
+
+      // First vertex of each face, and check the topology before indexing with it
+      std::vector<size_t> faceStarts(faceCount + 1, 0);
+      for(size_t face = 0; face < faceCount; ++face) {
+        if(faceVertexCounts[face] < 0) {
+          return {};
+        }
+        faceStarts[face + 1] = faceStarts[face] + faceVertexCounts[face];
+      }
+      if(faceStarts.back() != faceVertexIndices.size()) {
+        return {};
+      }
+      for(const int index : faceVertexIndices) {
+        if(index < 0 || static_cast<size_t>(index) >= pointCount) {
+          return {};
+        }
+      }
+
+      std::vector<GfVec3f> centroids(faceCount);
+      WorkParallelForN(faceCount, [&](size_t begin, size_t end) {
+        for(size_t face = begin; face < end; ++face) {
+          GfVec3f sum(0.0f);
+          for(size_t v = faceStarts[face]; v < faceStarts[face + 1]; ++v) {
+            sum += GfVec3f(points + 3 * faceVertexIndices[v]);
+          }
+          const size_t count = faceStarts[face + 1] - faceStarts[face];
+          centroids[face] = count > 0 ? sum / static_cast<float>(count) : sum;
+        }
+      });
+
+      std::vector<unsigned> faces(faceCount);
+      std::iota(faces.begin(), faces.end(), 0u);
+      const auto ranges = PartitionFaces(faces, centroids, maxFaces);
+
+      std::vector<MeshChunk> chunks(ranges.size());
+      WorkParallelForN(ranges.size(), [&](size_t begin, size_t end) {
+        for(size_t c = begin; c < end; ++c) {
+          MeshChunk& chunk = chunks[c];
+          // Keep the source order, so the chunk elements are ascending
+          std::sort(faces.begin() + ranges[c].first,
+                    faces.begin() + ranges[c].second);
+
+          for(size_t i = ranges[c].first; i < ranges[c].second; ++i) {
+            const unsigned face = faces[i];
+            chunk.faceVertexCounts.push_back(faceVertexCounts[face]);
+            for(size_t v = faceStarts[face]; v < faceStarts[face + 1]; ++v) {
+              chunk.vertices.push_back(static_cast<unsigned>(v));
+              chunk.points.push_back(
+                  static_cast<unsigned>(faceVertexIndices[v]));
+            }
+          }
+          std::sort(chunk.points.begin(), chunk.points.end());
+          chunk.points.erase(
+              std::unique(chunk.points.begin(), chunk.points.end()),
+              chunk.points.end());
+
+          // A search of the sorted points instead of a map the size of the whole mesh per task
+          chunk.faceVertexIndices.reserve(chunk.vertices.size());
+          for(const unsigned v : chunk.vertices) {
+            const auto it = std::lower_bound(
+                chunk.points.cbegin(), chunk.points.cend(),
+                static_cast<unsigned>(faceVertexIndices[v]));
+            chunk.faceVertexIndices.push_back(
+                static_cast<int>(it - chunk.points.cbegin()));
+          }
+        }
+      });
+      return chunks;
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
@@ -0,0 +1,319 @@
+// Copyright 2021 Foundry
+//
+// Licensed under the Apache License, Version 2.0 (the "Apache License")
+// with the following modification; you may not use this file except in
+// compliance with the Apache License and the following modification to it:
+// Section 6. Trademarks. is deleted and replaced with:
+//
+// 6. Trademarks. This License does not grant permission to use the trade
+//    names, trademarks, service marks, or product names of the Licensor
+//    and its affiliates, except as required to comply with Section 4(c) of
+//    the License and to reproduce the content of the NOTICE file.
+//
+// You may obtain a copy of the Apache License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the Apache License with the above modification is
+// distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the Apache License for the specific
+// language governing permissions and limitations under the Apache License.
+
+/*! \file
+ \brief Implementation file for UsdConverter sub-frame sampling of point based prims
+ */
+
+#include "UsdConverter/UsdMotionSamples.h"
+
+#include <pxr/base/work/loops.h>
+#include <pxr/usd/usd/stage.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define USD_CONVERTER_SSE2 1
+#endif
+
+namespace Foundry
+{
+  namespace UsdConverter
+  {
+    PXR_NAMESPACE_USING_DIRECTIVE
+
+    namespace
+    {
+      /// Check that an optional per point attribute has a sample that lines up with the points sample
+      bool ReadAlignedSample(const UsdAttribute& attr, double time,
+                             double pointsTime, size_t count,
+                             VtVec3fArray* values)
+      {
+        if(!attr.HasValue()) {
+          return false;
+        }
+        double lower, upper;
+        bool hasTimeSamples = false;
+        if(!attr.GetBracketingTimeSamples(time, &lower, &upper,
+                                          &hasTimeSamples)) {
+          return false;
+        }
+        // Samples that don't line up with the points can't be used
+        if(hasTimeSamples && lower != pointsTime) {
+          return false;
+        }
+        return attr.Get(values, pointsTime) && values->size() == count;
+      }
+
+      /// Arrays with fewer floats than this are not worth splitting across threads
+      const size_t kParallelThreshold = 1 << 16;
+
+      /// Call fn(begin, end) over [0, n), in parallel chunks for large arrays
+      template <class FN>
+      void ForEachChunk(size_t n, FN&& fn)
+      {
+        if(n < kParallelThreshold) {
+          fn(size_t(0), n);
+        }
+        else {
+          WorkParallelForN(n, fn);
+        }
+      }
+
+      // The Gf vectors are tightly packed floats, so the x, y and z components
+      // are processed as one flat array, four floats at a time.
+
+      /// out = p + v * dt + 0.5 * a * dt^2 over [begin, end), a may be null
+      void ExtrapolateRange(const float* p, const float* v, const float* a,
+                            float dt, size_t begin, size_t end, float* out)
+      {
+        const float halfDt2 = 0.5f * dt * dt;
+        size_t i = begin;
+#ifdef USD_CONVERTER_SSE2
+        const __m128 dt4 = _mm_set1_ps(dt);
+        const __m128 halfDt24 = _mm_set1_ps(halfDt2);
+        if(a) {
+          for(; i + 4 <= end; i += 4) {
+            const __m128 r = _mm_add_ps(
+                _mm_loadu_ps(p + i),
+                _mm_add_ps(_mm_mul_ps(dt4, _mm_loadu_ps(v + i)),
+                           _mm_mul_ps(halfDt24, _mm_loadu_ps(a + i))));
+            _mm_storeu_ps(out + i, r);
+          }
+        }
+        else {
+          for(; i + 4 <= end; i += 4) {
+            const __m128 r = _mm_add_ps(_mm_loadu_ps(p + i),
+                                        _mm_mul_ps(dt4, _mm_loadu_ps(v + i)));
+            _mm_storeu_ps(out + i, r);
+          }
+        }
+#endif
+        // Scalar fallback and the remaining tail
+        if(a) {
+          for(; i < end; ++i) {
+            out[i] = p[i] + (dt * v[i] + halfDt2 * a[i]);
+          }
+        }
+        else {
+          for(; i < end; ++i) {
+            out[i] = p[i] + dt * v[i];
+          }
+        }
+      }
+
+      /// out = lower + (upper - lower) * alpha over [begin, end)
+      void LerpRange(const float* lower, const float* upper, float alpha,
+                     size_t begin, size_t end, float* out)
+      {
+        size_t i = begin;
+#ifdef USD_CONVERTER_SSE2
+        const __m128 alpha4 = _mm_set1_ps(alpha);
+        for(; i + 4 <= end; i += 4) {
+          const __m128 l = _mm_loadu_ps(lower + i);
+          const __m128 r = _mm_add_ps(
+              l, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(upper + i), l), alpha4));
+          _mm_storeu_ps(out + i, r);
+        }
+#endif
+        for(; i < end; ++i) {
+          out[i] = lower[i] + (upper[i] - lower[i]) * alpha;
+        }
+      }
+    }  // namespace
+
+    bool ReadPointSamples(const UsdGeomPointBased& fromPrim, UsdTimeCode time,
+                          PointSamples* samples)
+    {
+      // Without velocities the points are interpolated as usual
+      if(!time.IsNumeric() || !fromPrim.GetVelocitiesAttr().HasValue()) {
+        return false;
+      }
+
+      const UsdAttribute pointsAttr = fromPrim.GetPointsAttr();
+      double lower, upper;
+      bool hasTimeSamples = false;
+      if(!pointsAttr.GetBracketingTimeSamples(time.GetValue(), &lower, &upper,
+                                              &hasTimeSamples) ||
+         !hasTimeSamples || lower == time.GetValue()) {
+        // Static points, or the time is on an authored sample
+        return false;
+      }
+
+      samples->time = lower;
+      samples->timeCodesPerSecond =
+          fromPrim.GetPrim().GetStage()->GetTimeCodesPerSecond();
+      if(!pointsAttr.Get(&samples->points, lower) ||
+         !ReadAlignedSample(fromPrim.GetVelocitiesAttr(), time.GetValue(),
+                            lower, samples->points.size(),
+                            &samples->velocities)) {
+        return false;
+      }
+      if(!ReadAlignedSample(fromPrim.GetAccelerationsAttr(), time.GetValue(),
+                            lower, samples->points.size(),
+                            &samples->accelerations)) {
+        samples->accelerations.clear();
+      }
+      return true;
+    }
+
+    void ExtrapolatePoints(const PointSamples& samples, double time, float* out)
+    {
+      const size_t n = samples.points.size() * 3;
+      if(n == 0) {
+        return;
+      }
+      const float dt = static_cast<float>((time - samples.time) /
+                                          samples.timeCodesPerSecond);
+      const float* p = samples.points.cdata()->data();
+      const float* v = samples.velocities.cdata()->data();
+      const float* a = samples.accelerations.empty()
+                           ? nullptr
+                           : samples.accelerations.cdata()->data();
+      ForEachChunk(n, [&](size_t begin, size_t end) {
+        ExtrapolateRange(p, v, a, dt, begin, end, out);
+      });
+    }
+
+    bool ReadBracketingSamples(const UsdGeomPointBased& fromPrim,
+                               UsdTimeCode time,
+                               const BracketingSamples* previous,
+                               BracketingSamples* samples)
+    {
+      if(!time.IsNumeric()) {
+        return false;
+      }
+      const UsdAttribute pointsAttr = fromPrim.GetPointsAttr();
+      double lower, upper;
+      bool hasTimeSamples = false;
+      if(!pointsAttr.GetBracketingTimeSamples(time.GetValue(), &lower, &upper,
+                                              &hasTimeSamples) ||
+         !hasTimeSamples || lower == upper || lower == time.GetValue()) {
+        // Static points, outside of the sampled range or on an authored sample
+        return false;
+      }
+
+      samples->lowerTime = lower;
+      samples->upperTime = upper;
+      samples->held = fromPrim.GetPrim().GetStage()->GetInterpolationType() ==
+                      UsdInterpolationTypeHeld;
+
+      // The arrays of a held previous load may be incomplete
+      if(previous && previous->held) {
+        previous = nullptr;
+      }
+
+      // Stepping forward through the frames the previous upper sample becomes the lower one
+      if(previous && previous->upperTime == lower) {
+        samples->lower = previous->upper;
+      }
+      else if(previous && previous->lowerTime == lower) {
+        samples->lower = previous->lower;
+      }
+      else if(!pointsAttr.Get(&samples->lower, lower)) {
+        return false;
+      }
+
+      if(previous && previous->upperTime == upper) {
+        samples->upper = previous->upper;
+      }
+      else if(!samples->held && !pointsAttr.Get(&samples->upper, upper)) {
+        return false;
+      }
+      return true;
+    }
+
+    size_t InterpolatePoints(const BracketingSamples& samples, double time,
+                             float* out)
+    {
+      const size_t count = samples.lower.size();
+      const size_t n = count * 3;
+      if(n == 0) {
+        return count;
+      }
+      const float* lower = samples.lower.cdata()->data();
+      if(samples.held || samples.upper.size() != count) {
+        // Varying topology can't be blended, hold the lower sample like USD does
+        std::copy(lower, lower + n, out);
+        return count;
+      }
+
+      const float* upper = samples.upper.cdata()->data();
+      const float alpha = static_cast<float>(
+          (time - samples.lowerTime) / (samples.upperTime - samples.lowerTime));
+      ForEachChunk(n, [&](size_t begin, size_t end) {
+        LerpRange(lower, upper, alpha, begin, end, out);
+      });
+      return count;
+    }
+
+    std::vector<double> ShutterTimes(double time, size_t samples, double shutter)
+    {
+      const double frame = std::round(time);
+      if(samples < 2) {
+        return {frame};
+      }
+      std::vector<double> times(samples);
+      for(size_t i = 0; i < samples; ++i) {
+        times[i] = frame + shutter * (static_cast<double>(i) / (samples - 1) - 0.5);
+      }
+      return times;
+    }
+
+    namespace
+    {
+      /// Sample times are computed the same way every time, so only rounding needs allowing for
+      const double kTimeTolerance = 1e-6;
+    }  // namespace
+
+    const VtMatrix4dArray* InstanceTransformSamples::find(double time) const
+    {
+      for(size_t i = 0; i < times.size(); ++i) {
+        if(std::abs(times[i] - time) < kTimeTolerance) {
+          return &transforms[i];
+        }
+      }
+      return nullptr;
+    }
+
+    bool ReadInstanceTransformSamples(const UsdGeomPointInstancer& instancer,
+                                      const std::vector<double>& times,
+                                      InstanceTransformSamples* samples)
+    {
+      if(times.empty()) {
+        return false;
+      }
+      std::vector<UsdTimeCode> timeCodes(times.begin(), times.end());
+      // Velocities extrapolate from the frame, as if it was evaluated alone
+      const UsdTimeCode baseTime(std::round(times.front() +
+                                            (times.back() - times.front()) / 2));
+      samples->times = times;
+      // One transform per instance, masked or not, like a single frame
+      return instancer.ComputeInstanceTransformsAtTimes(
+          &samples->transforms, timeCodes, baseTime,
+          UsdGeomPointInstancer::IncludeProtoXform,
+          UsdGeomPointInstancer::IgnoreMask);
+    }
+  }  // namespace UsdConverter
+}  // namespace Foundry
@@ -34,9 +34,11 @@
 
 #include <catch2/catch.hpp>
 #include <iterator>
+#include <limits>
 
 #include "TestFixtures.h"
 #include "UsdConverter/UsdAttrConverter.h"
+#include "UsdConverter/UsdHalfFloats.h"
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
@@ -80,6 +82,30 @@ TEST_CASE("Offset into array")
   }
 }
 
+TEST_CASE("Span of array")
+{
+  VtVec3fArray source{{1, 2, 3},    {3, 5, 6},    {7, 8, 9},
+                      {10, 11, 12}, {13, 14, 15}, {16, 17, 18}};
+  SECTION("Whole array")
+  {
+    ArraySpan<GfVec3f> result(source);
+    REQUIRE(result.size() == source.size());
+    CHECK(result.begin() == source.cdata());
+  }
+  SECTION("Offset 1 and stride 3 views the [3-6) elements without copying")
+  {
+    ArraySpan<GfVec3f> result(source, 1, 3);
+    REQUIRE(result.size() == 3);
+    CHECK(result.begin() == source.cdata() + 3);
+    CHECK(result[0] == GfVec3f(10, 11, 12));
+  }
+  SECTION("Out of range is empty")
+  {
+    ArraySpan<GfVec3f> result(source, 2, 3);
+    CHECK(result.empty());
+  }
+}
+
 TEST_CASE("ComputePrimvar - type conversion.")
 {
   UsdStageRefPtr stage = UsdStage::CreateInMemory();
@@ -127,6 +153,55 @@ TEST_CASE("ComputePrimvar - type conversion.")
     ComputePrimvar(result, attribute, UsdTimeCode::Default());
     CHECK(std::equal(expected.begin(), expected.end(), result.begin()));
   }
+  SECTION("Wider to narrower vector - extra components dropped")
+  {
+    UsdGeomPrimvar attribute = api.CreatePrimvar(
+        TfToken("float4array"), SdfValueTypeNames->Float4Array);
+    attribute.Set(VtVec4fArray{{1, 2, 3, 4}});
+    VtVec3fArray result;
+    ComputePrimvar(result, attribute, UsdTimeCode::Default());
+    CHECK(result == VtVec3fArray{{1, 2, 3}});
+  }
+}
+
+TEST_CASE("Supported primvar conversions")
+{
+  CHECK(CanComputePrimvar<VtVec3fArray>(TfType::Find<VtVec3fArray>()));
+  CHECK(CanComputePrimvar<VtVec3fArray>(TfType::Find<VtVec3dArray>()));
+  CHECK(CanComputePrimvar<VtVec3fArray>(TfType::Find<VtVec4hArray>()));
+  CHECK(CanComputePrimvar<VtFloatArray>(TfType::Find<VtIntArray>()));
+  CHECK(CanComputePrimvar<VtMatrix4fArray>(TfType::Find<VtMatrix4dArray>()));
+  CHECK_FALSE(CanComputePrimvar<VtMatrix3dArray>(TfType::Find<VtMatrix4dArray>()));
+  CHECK_FALSE(CanComputePrimvar<VtVec3fArray>(TfType::Find<VtFloatArray>()));
+  CHECK_FALSE(CanComputePrimvar<VtFloatArray>(TfType::Find<VtMatrix4dArray>()));
+  CHECK_FALSE(CanComputePrimvar<VtFloatArray>(TfType::Find<VtStringArray>()));
+}
+
+TEST_CASE("Attribute conversion targets")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomMesh mesh = UsdGeomMesh::Define(stage, SdfPath("/mesh"));
+  UsdGeomPrimvar color = mesh.CreateDisplayColorPrimvar(UsdGeomTokens->vertex);
+  UsdGeomMesh other = UsdGeomMesh::Define(stage, SdfPath("/other"));
+  UsdGeomPrimvar otherColor =
+      other.CreateDisplayColorPrimvar(UsdGeomTokens->uniform);
+
+  SECTION("Mapped attributes get their Nuke name, group and type")
+  {
+    const AttributeTarget target = ResolveAttributeTarget(color.GetAttr());
+    REQUIRE(target.convert);
+    CHECK(target.name == TfToken(kColorAttrName));
+    CHECK(target.group == Group_Points);
+    CHECK(target.type == ConvertAttribType(color.GetAttr()));
+  }
+  SECTION("Targets follow the interpolation")
+  {
+    CHECK(ResolveAttributeTarget(otherColor.GetAttr()).group == Group_Primitives);
+  }
+  SECTION("Attributes without a Nuke counterpart aren't converted")
+  {
+    CHECK_FALSE(ResolveAttributeTarget(mesh.GetFaceVertexCountsAttr()).convert);
+  }
 }
 
 TEST_CASE("Attribute promotion")
@@ -207,6 +282,23 @@ TEST_CASE_METHOD(MemoryAllocator, "Color conversion")
     CHECK(std::equal(expectedResults.begin(), expectedResults.end(),
                      Cf.vector4_list->begin()));
   }
+
+  SECTION("Point color with vertex opacity")
+  {
+    const VtArray<GfVec3f> color{{1, 0, 0}, {2, 0, 0}, {3, 0, 0}};
+    const VtFloatArray opacity{0.5f, 0.3f, 0.9f, 0.1f};
+    const VtUIntArray vertexPoints{2, 0, 1, 2};
+
+    ConvertColor(Cf, color, Group_Points, opacity, Group_Vertices,
+                 vertexPoints);
+    const std::vector<Vector4> expectedResults{{3.0f, 0, 0, 0.5f},
+                                               {1.0f, 0, 0, 0.3f},
+                                               {2.0f, 0, 0, 0.9f},
+                                               {3.0f, 0, 0, 0.1f}};
+    REQUIRE(Cf.vector4_list->size() == expectedResults.size());
+    CHECK(std::equal(expectedResults.begin(), expectedResults.end(),
+                     Cf.vector4_list->begin()));
+  }
 }
 
 TEST_CASE("UV Attribute ordering")
@@ -227,6 +319,32 @@ TEST_CASE("UV Attribute ordering")
   CHECK(UvOrdering(st, z) == true);
 }
 
+TEST_CASE("Convertible attributes")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomMesh mesh = UsdGeomMesh::Define(stage, SdfPath("/unit_test"));
+  mesh.CreateDoubleSidedAttr().Set(true);
+  mesh.CreateFaceVertexIndicesAttr().Set(VtIntArray{0, 1, 2});
+  mesh.CreateNormalsAttr().Set(VtVec3fArray{{0, 0, 1}});
+  mesh.CreateDisplayColorPrimvar().Set(VtVec3fArray{{1, 0, 0}});
+  // Declared without a value, so there is nothing to convert
+  UsdGeomPrimvarsAPI(mesh).CreatePrimvar(TfToken("empty"),
+                                         SdfValueTypeNames->Float2);
+
+  TfToken::HashSet names;
+  for(const auto& attr : ConvertibleAttributes(mesh.GetPrim())) {
+    names.insert(attr.GetName());
+  }
+  CHECK(names.count(UsdGeomTokens->faceVertexIndices) == 1);
+  CHECK(names.count(UsdGeomTokens->normals) == 1);
+  CHECK(names.count(UsdGeomTokens->primvarsDisplayColor) == 1);
+  // Builtins without a value aren't candidates either
+  CHECK(names.count(UsdGeomTokens->velocities) == 0);
+  CHECK(names.count(UsdGeomTokens->doubleSided) == 0);
+  CHECK(names.count(UsdGeomTokens->extent) == 0);
+  CHECK(names.count(TfToken("primvars:empty")) == 0);
+}
+
 TEST_CASE_METHOD(MemoryAllocator, "UV conversion")
 {
   Attribute attribute(kUVAttrName, VECTOR4_ATTRIB);
@@ -324,4 +442,99 @@ TEST_CASE_METHOD(MemoryAllocator, "Value conversion from USD to attribute")
     }
     REQUIRE(toAttr->vector3_list->size() == 4);
   }
+
+  SECTION("Half colors are decoded into floats")
+  {
+    const VtVec3hArray colors{{GfHalf(0.5f), GfHalf(1.0f), GfHalf(-2.0f)},
+                              {GfHalf(0.25f), GfHalf(0.0f), GfHalf(65504.0f)}};
+    UsdAttribute fromAttr =
+        UsdGeomPrimvarsAPI(fromMesh)
+            .CreatePrimvar(TfToken("halfColor"), SdfValueTypeNames->Color3hArray,
+                           UsdGeomTokens->vertex)
+            .GetAttr();
+    fromAttr.Set(colors, pxr::UsdTimeCode::Default());
+
+    TestGeoOp geo;
+    int obj = geo.geometryList()->size();
+    geo.geometryList()->add_object(obj);
+    geo.geometryList()->add_primitive(obj);
+    Attribute* toAttr = geo.geometryList()->writable_attribute(
+        obj, Group_Points, "halfColor", VECTOR3_ATTRIB);
+
+    ConvertValues(toAttr, fromAttr, UsdTimeCode::Default());
+
+    REQUIRE(toAttr->vector3_list->size() == 2);
+    CHECK((*toAttr->vector3_list)[0] == Vector3(0.5f, 1.0f, -2.0f));
+    CHECK((*toAttr->vector3_list)[1] == Vector3(0.25f, 0.0f, 65504.0f));
+  }
+
+  SECTION("Indexed primvars are gathered into the attribute")
+  {
+    UsdGeomPrimvar primvar = UsdGeomPrimvarsAPI(fromMesh).CreatePrimvar(
+        TfToken("indexed"), SdfValueTypeNames->Float3Array,
+        UsdGeomTokens->faceVarying);
+    primvar.Set(VtVec3fArray{{1, 0, 0}, {0, 2, 0}, {0, 0, 3}});
+    // Enough indices to be gathered in parallel chunks
+    VtIntArray indices(100000);
+    for(size_t i = 0; i < indices.size(); ++i) {
+      indices[i] = static_cast<int>((i * 7) % 3);
+    }
+    primvar.SetIndices(indices);
+
+    TestGeoOp geo;
+    int obj = geo.geometryList()->size();
+    geo.geometryList()->add_object(obj);
+    geo.geometryList()->add_primitive(obj);
+    Attribute* toAttr = geo.geometryList()->writable_attribute(
+        obj, Group_Vertices, "indexed", VECTOR3_ATTRIB);
+
+    ConvertValues(toAttr, primvar.GetAttr(), UsdTimeCode::Default());
+
+    VtVec3fArray flattened;
+    REQUIRE(primvar.ComputeFlattened(&flattened, UsdTimeCode::Default()));
+    REQUIRE(toAttr->vector3_list->size() == flattened.size());
+    CHECK_THAT(flattened, ArraysOfVectorsEqual<decltype(flattened)>(
+                              *toAttr->vector3_list, 3));
+  }
+
+  SECTION("Indexed primvars with several values per index are flattened")
+  {
+    UsdGeomPrimvar primvar = UsdGeomPrimvarsAPI(fromMesh).CreatePrimvar(
+        TfToken("pairs"), SdfValueTypeNames->FloatArray,
+        UsdGeomTokens->vertex, 2);
+    primvar.Set(VtFloatArray{1, 2, 3, 4});
+    primvar.SetIndices(VtIntArray{1, 0, 1});
+
+    TestGeoOp geo;
+    int obj = geo.geometryList()->size();
+    geo.geometryList()->add_object(obj);
+    geo.geometryList()->add_primitive(obj);
+    Attribute* toAttr = geo.geometryList()->writable_attribute(
+        obj, Group_Points, "pairs", FLOAT_ATTRIB);
+
+    ConvertValues(toAttr, primvar.GetAttr(), UsdTimeCode::Default());
+
+    CHECK(*toAttr->float_list == std::vector<float>{3, 4, 1, 2, 3, 4});
+  }
+}
+
+TEST_CASE("Half float decoding")
+{
+  // Enough for the eight wide decoding and a tail, with zeros, subnormals and infinities
+  std::vector<GfHalf> halfs;
+  for(int i = 0; i < 21; ++i) {
+    halfs.push_back(GfHalf(static_cast<float>(i - 10) * 0.37f));
+  }
+  halfs.push_back(GfHalf(-0.0f));
+  halfs.push_back(GfHalf(std::numeric_limits<float>::infinity()));
+  GfHalf subnormal;
+  subnormal.setBits(1);
+  halfs.push_back(subnormal);
+
+  std::vector<float> decoded(halfs.size());
+  DecodeHalfs(halfs.data(), halfs.size(), decoded.data());
+  for(size_t i = 0; i < halfs.size(); ++i) {
+    CHECK(decoded[i] == static_cast<float>(halfs[i]));
+  }
+}
 }
@@ -29,6 +29,7 @@
 #include <DDImage/PolyMesh.h>
 #include <DDImage/Scene.h>
 #include <pxr/base/gf/rotation.h>
+#include <pxr/base/work/threadLimits.h>
 #include <pxr/pxr.h>
 #include <pxr/usd/sdf/path.h>
 #include <pxr/usd/sdf/types.h>
@@ -42,11 +43,20 @@
 #include <pxr/usd/usdGeom/primvarsAPI.h>
 #include <pxr/usd/usdGeom/xformCache.h>
 #include <pxr/usd/usdGeom/xformCommonAPI.h>
+#include <pxr/usd/usdGeom/xform.h>
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 #include "TestFixtures.h"
+#include "UsdConverter/UsdAttributeFilter.h"
+#include "UsdConverter/UsdCommon.h"
+#include "UsdConverter/UsdConversionCache.h"
 #include "UsdConverter/UsdGeoConverter.h"
+#include "UsdConverter/UsdHierarchy.h"
+#include "UsdConverter/UsdMeshChunks.h"
 #include "UsdConverter/UsdUI.h"
 
 PXR_NAMESPACE_USING_DIRECTIVE
@@ -292,6 +302,821 @@ TEST_CASE("Prim conversions")
   }
 }
 
+TEST_CASE_METHOD(MemoryAllocator, "Sub-frame points")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  // One time code per second keeps the expected values exact
+  stage->SetTimeCodesPerSecond(1.0);
+  UsdGeomPoints fromPoints = UsdGeomPoints::Define(stage, SdfPath("/points"));
+  UsdAttribute a_points = fromPoints.CreatePointsAttr();
+  a_points.Set(VtVec3fArray{{0, 0, 0}, {1, 1, 1}}, UsdTimeCode(1));
+  a_points.Set(VtVec3fArray{{0, 0, 0}, {1, 1, 1}}, UsdTimeCode(2));
+
+  SECTION("Extrapolated with velocities and accelerations")
+  {
+    UsdAttribute a_velocities = fromPoints.CreateVelocitiesAttr();
+    a_velocities.Set(VtVec3fArray{{1, 0, 0}, {0, 2, 0}}, UsdTimeCode(1));
+    UsdAttribute a_accelerations = fromPoints.CreateAccelerationsAttr();
+    a_accelerations.Set(VtVec3fArray{{0, 0, 0}, {0, 0, 4}}, UsdTimeCode(1));
+
+    TestGeoOp geo;
+    addUsdPrim<UsdGeomPoints>(*geo.geometryList(), fromPoints,
+                              UsdTimeCode(1.5));
+    const VtVec3fArray expected{{0.5f, 0, 0}, {1, 2, 1.5f}};
+    const PointList* toPoints = geo.geometryList()->object(0).point_list();
+    CHECK_THAT(expected,
+               ArraysOfVectorsEqual<decltype(expected)>(*toPoints, 3));
+  }
+
+  SECTION("Sample is shared by the loads of a cache")
+  {
+    UsdAttribute a_velocities = fromPoints.CreateVelocitiesAttr();
+    a_velocities.Set(VtVec3fArray{{1, 0, 0}, {0, 1, 0}}, UsdTimeCode(1));
+
+    ConversionCache cache;
+    const auto first = cache.pointSamples(fromPoints, UsdTimeCode(1.25));
+    const auto second = cache.pointSamples(fromPoints, UsdTimeCode(1.75));
+    REQUIRE(first);
+    CHECK(first == second);
+    CHECK_FALSE(cache.pointSamples(fromPoints, UsdTimeCode(1)));
+  }
+
+  SECTION("Interpolated without velocities")
+  {
+    ConversionCache cache;
+    CHECK_FALSE(cache.pointSamples(fromPoints, UsdTimeCode(1.5)));
+  }
+}
+
+TEST_CASE("Interpolated points")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomPoints fromPoints = UsdGeomPoints::Define(stage, SdfPath("/points"));
+  UsdAttribute a_points = fromPoints.CreatePointsAttr();
+  a_points.Set(VtVec3fArray{{0, 0, 0}, {1, 1, 1}}, UsdTimeCode(1));
+  a_points.Set(VtVec3fArray{{2, 0, 0}, {1, 3, 1}}, UsdTimeCode(2));
+  a_points.Set(VtVec3fArray{{4, 0, 0}, {1, 5, 1}}, UsdTimeCode(3));
+
+  ConversionCache cache;
+  const auto first = cache.bracketingSamples(fromPoints, UsdTimeCode(1.25));
+  REQUIRE(first);
+  CHECK(first == cache.bracketingSamples(fromPoints, UsdTimeCode(1.75)));
+  CHECK_FALSE(cache.bracketingSamples(fromPoints, UsdTimeCode(2)));
+
+  float interpolated[6];
+  CHECK(InterpolatePoints(*first, 1.5, interpolated) == 2);
+  const float expected[6] = {1, 0, 0, 1, 2, 1};
+  for(int i = 0; i < 6; ++i) {
+    CHECK(interpolated[i] == expected[i]);
+  }
+
+  // The next frame's lower sample is the previous upper one
+  const auto next = cache.bracketingSamples(fromPoints, UsdTimeCode(2.5));
+  REQUIRE(next);
+  CHECK(next->lower.cdata() == first->upper.cdata());
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Attribute queries are kept by the cache")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomMesh mesh = UsdGeomMesh::Define(stage, SdfPath("/quad"));
+  mesh.CreatePointsAttr().Set(
+      VtVec3fArray{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}});
+  mesh.CreateFaceVertexCountsAttr().Set(VtIntArray{3, 3});
+  mesh.CreateFaceVertexIndicesAttr().Set(VtIntArray{0, 1, 2, 0, 2, 3});
+  UsdGeomPrimvar color =
+      mesh.CreateDisplayColorPrimvar(UsdGeomTokens->uniform);
+  color.Set(VtVec3fArray{{1, 0, 0}, {0, 1, 0}});
+  color.SetIndices(VtIntArray{1, 0});
+  mesh.CreateVelocitiesAttr().Set(
+      VtVec3fArray{{0, 1, 0}, {0, 2, 0}, {0, 3, 0}, {0, 4, 0}});
+
+  ConversionCache cache;
+  const auto colorQueries = cache.attributeQueries(color.GetAttr());
+  REQUIRE(colorQueries);
+  CHECK(colorQueries == cache.attributeQueries(color.GetAttr()));
+  CHECK(colorQueries->indices.IsValid());
+  CHECK_FALSE(
+      cache.attributeQueries(mesh.GetVelocitiesAttr())->indices.IsValid());
+
+  // Every load reads through the same queries
+  for(int load = 0; load < 2; ++load) {
+    TestGeoOp geo;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       &cache);
+    REQUIRE(geo.geometryList()->size() == 1);
+    const GeoInfo& info = geo.geometryList()->object(0);
+    const Attribute* Cf =
+        info.get_group_attribute(Group_Primitives, kColorAttrName);
+    REQUIRE(Cf);
+    CHECK(Cf->vector4(0) == Vector4(0, 1, 0, 1));
+    CHECK(Cf->vector4(1) == Vector4(1, 0, 0, 1));
+    const Attribute* vel =
+        info.get_group_attribute(Group_Points, kVelocityAttrName);
+    REQUIRE(vel);
+    CHECK(vel->vector3(3) == Vector3(0, 4, 0));
+  }
+
+  // Each index of an indexed primvar selects elementSize values
+  UsdGeomMesh pairs = UsdGeomMesh::Define(stage, SdfPath("/pairs"));
+  UsdGeomPrimvar pairColor =
+      pairs.CreateDisplayColorPrimvar(UsdGeomTokens->vertex, 2);
+  pairColor.Set(VtVec3fArray{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1}});
+  pairColor.SetIndices(VtIntArray{1, 0});
+  REQUIRE(cache.attributeQueries(pairColor.GetAttr())->elementSize == 2);
+  ConvertedAttribute converted;
+  int elementSize = 0;
+  REQUIRE(ConvertUsdAttribute(pairColor.GetAttr(), UsdTimeCode::Default(),
+                              &converted, &cache, &elementSize));
+  CHECK(elementSize == 2);
+  VtVec3fArray flattened;
+  REQUIRE(pairColor.ComputeFlattened(&flattened, UsdTimeCode::Default()));
+  REQUIRE(flattened.size() == 4);
+  CHECK_THAT(flattened, ArraysOfVectorsEqual<decltype(flattened)>(
+                            *converted.attribute->vector3_list, 3));
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Split large meshes")
+{
+  // A strip of four quads along x, the bottom row of points first
+  VtVec3fArray points;
+  for(int row = 0; row < 2; ++row) {
+    for(int column = 0; column < 5; ++column) {
+      points.emplace_back(static_cast<float>(column), static_cast<float>(row), 0.0f);
+    }
+  }
+  const VtIntArray faceVertexCounts{4, 4, 4, 4};
+  const VtIntArray faceVertexIndices{0, 1, 6, 5, 1, 2, 7, 6,
+                                     2, 3, 8, 7, 3, 4, 9, 8};
+
+  SECTION("Chunks of neighbouring faces")
+  {
+    const auto chunks =
+        SplitMesh(faceVertexCounts, faceVertexIndices,
+                  points.cdata()->data(), points.size(), 2);
+    REQUIRE(chunks.size() == 2);
+    CHECK(chunks[0].points == std::vector<unsigned>{0, 1, 2, 5, 6, 7});
+    CHECK(chunks[0].vertices == std::vector<unsigned>{0, 1, 2, 3, 4, 5, 6, 7});
+    CHECK(chunks[0].faceVertexIndices == std::vector<int>{0, 1, 4, 3, 1, 2, 5, 4});
+    CHECK(chunks[1].points == std::vector<unsigned>{2, 3, 4, 7, 8, 9});
+    CHECK(SplitMesh(faceVertexCounts, faceVertexIndices,
+                    points.cdata()->data(), points.size(), 4)
+              .empty());
+  }
+
+  SECTION("Chunks become objects")
+  {
+    UsdStageRefPtr stage = UsdStage::CreateInMemory();
+    UsdGeomMesh fromMesh = UsdGeomMesh::Define(stage, SdfPath("/strip"));
+    fromMesh.CreatePointsAttr().Set(points);
+    fromMesh.CreateFaceVertexCountsAttr().Set(faceVertexCounts);
+    fromMesh.CreateFaceVertexIndicesAttr().Set(faceVertexIndices);
+
+    ConversionOptions options;
+    options.splitFaceCount = 2;
+    TestGeoOp geo;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    REQUIRE(geo.geometryList()->size() == 2);
+    for(int obj = 0; obj < 2; ++obj) {
+      const GeoInfo& info = geo.geometryList()->object(obj);
+      CHECK(info.point_list()->size() == 6);
+      const Attribute* name =
+          info.get_group_attribute(Group_Object, kNameAttrName);
+      REQUIRE(name);
+      CHECK((*name->std_string_list)[0] ==
+            "/strip:chunk" + std::to_string(obj));
+    }
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Merge small meshes")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  for(int i = 0; i < 2; ++i) {
+    UsdGeomMesh fromMesh = UsdGeomMesh::Define(
+        stage, SdfPath("/triangle" + std::to_string(i)));
+    fromMesh.CreatePointsAttr().Set(VtVec3fArray{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}});
+    fromMesh.CreateFaceVertexCountsAttr().Set(VtIntArray{3});
+    fromMesh.CreateFaceVertexIndicesAttr().Set(VtIntArray{0, 1, 2});
+    fromMesh.AddTranslateOp().Set(GfVec3d(10.0 * i, 0, 0));
+  }
+  UsdGeomCube::Define(stage, SdfPath("/cube"));
+
+  ConversionOptions options;
+  options.mergeFaceCount = 1;
+  TestGeoOp geo;
+  convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                     nullptr, options);
+  // The cube, then the merged triangles
+  REQUIRE(geo.geometryList()->size() == 2);
+  const GeoInfo& info = geo.geometryList()->object(1);
+  CHECK(info.primitives() == 2);
+  const VtVec3fArray expected{{0, 0, 0},  {1, 0, 0},  {0, 1, 0},
+                              {10, 0, 0}, {11, 0, 0}, {10, 1, 0}};
+  CHECK_THAT(expected,
+             ArraysOfVectorsEqual<decltype(expected)>(*info.point_list(), 3));
+  const Attribute* names =
+      info.get_group_attribute(Group_Primitives, kNameAttrName);
+  REQUIRE(names);
+  CHECK(*names->std_string_list ==
+        std::vector<std::string>{"/triangle0", "/triangle1"});
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Indexed uvs")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomMesh mesh = UsdGeomMesh::Define(stage, SdfPath("/quad"));
+  mesh.CreatePointsAttr().Set(
+      VtVec3fArray{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}});
+  mesh.CreateFaceVertexCountsAttr().Set(VtIntArray{3, 3});
+  mesh.CreateFaceVertexIndicesAttr().Set(VtIntArray{0, 1, 2, 0, 2, 3});
+  UsdGeomPrimvar st = UsdGeomPrimvarsAPI(mesh).CreatePrimvar(
+      TfToken("st"), SdfValueTypeNames->TexCoord2fArray,
+      UsdGeomTokens->faceVarying);
+  const VtVec2fArray values{{0, 0}, {1, 0}, {1, 1}, {0, 1}, {0.5f, 0.5f}};
+  st.Set(values);
+
+  TestGeoOp geo;
+  SECTION("Stored per point when every vertex of a point uses the same uv")
+  {
+    st.SetIndices(VtIntArray{0, 1, 2, 0, 2, 3});
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default());
+    REQUIRE(geo.geometryList()->size() == 1);
+    const GeoInfo& info = geo.geometryList()->object(0);
+    CHECK_FALSE(info.get_group_attribute(Group_Vertices, kUVAttrName));
+    const Attribute* uvs = info.get_group_attribute(Group_Points, kUVAttrName);
+    REQUIRE(uvs);
+    REQUIRE(uvs->size() == 4);
+    CHECK(uvs->vector4(3) == Vector4(0, 1, 0, 1));
+  }
+
+  SECTION("Flattened per vertex across seams")
+  {
+    st.SetIndices(VtIntArray{0, 1, 2, 4, 2, 3});
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default());
+    REQUIRE(geo.geometryList()->size() == 1);
+    const GeoInfo& info = geo.geometryList()->object(0);
+    const Attribute* uvs =
+        info.get_group_attribute(Group_Vertices, kUVAttrName);
+    REQUIRE(uvs);
+    REQUIRE(uvs->size() == 6);
+    CHECK(uvs->vector4(3) == Vector4(0.5f, 0.5f, 0, 1));
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Prototype templates")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomMesh triangle = UsdGeomMesh::Define(stage, SdfPath("/triangle"));
+  const VtVec3fArray points{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}};
+  triangle.CreatePointsAttr().Set(points);
+  triangle.CreateFaceVertexCountsAttr().Set(VtIntArray{3});
+  triangle.CreateFaceVertexIndicesAttr().Set(VtIntArray{0, 1, 2});
+  UsdGeomPrimvar color =
+      triangle.CreateDisplayColorPrimvar(UsdGeomTokens->constant);
+  color.Set(VtVec3fArray{{1, 0, 0}}, UsdTimeCode(1));
+  color.Set(VtVec3fArray{{0, 1, 0}}, UsdTimeCode(2));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(triangle.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0, 0});
+  instancer.CreatePositionsAttr().Set(VtVec3fArray{{0, 0, 0}, {5, 0, 0}});
+
+  ConversionCache cache;
+  const auto load = [&](double time, size_t instance) {
+    TestGeoOp geo;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode(time), &cache);
+    // The triangle, then one object per instance
+    REQUIRE(geo.geometryList()->size() == 3);
+    const GeoInfo& info = geo.geometryList()->object(1 + instance);
+    CHECK_THAT(points,
+               ArraysOfVectorsEqual<decltype(points)>(*info.point_list(), 3));
+    const Attribute* Cf =
+        info.get_group_attribute(Group_Object, kColorAttrName);
+    REQUIRE(Cf);
+    return Cf->vector4(0);
+  };
+
+  // The second load copies the template kept by the first
+  CHECK(load(1, 0) == Vector4(1, 0, 0, 1));
+  CHECK(load(1, 1) == Vector4(1, 0, 0, 1));
+  // The prototype's color animates, so it is converted again
+  CHECK(load(2, 1) == Vector4(0, 1, 0, 1));
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Animated cube size")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdAttribute size = cube.CreateSizeAttr();
+  size.Set(2.0, UsdTimeCode(1));
+  size.Set(4.0, UsdTimeCode(2));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0});
+  instancer.CreatePositionsAttr().Set(VtVec3fArray{{10, 0, 0}});
+
+  ConversionCache cache;
+  const auto extent = [](const GeoInfo& info) {
+    float extent = 0.0f;
+    for(const Vector3& p : *info.point_list()) {
+      extent = std::max({extent, std::abs(p.x), std::abs(p.y), std::abs(p.z)});
+    }
+    return extent;
+  };
+  for(const double time : {1.0, 2.0}) {
+    TestGeoOp geo;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode(time), &cache);
+    // The cube, then its instance
+    REQUIRE(geo.geometryList()->size() == 2);
+    CHECK(extent(geo.geometryList()->object(0)) == Approx(time));
+    CHECK(extent(geo.geometryList()->object(1)) == Approx(time));
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Parallel instance expansion")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  // Enough instances for every thread to expand several of them
+  const size_t nInstances = 4096;
+  VtVec3fArray positions(nInstances);
+  VtVec3fArray colors(nInstances);
+  for(size_t i = 0; i < nInstances; ++i) {
+    const float f = static_cast<float>(i);
+    positions[i] = GfVec3f(f, 0, 0);
+    colors[i] = GfVec3f(f / nInstances, 0, 1);
+  }
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray(nInstances, 0));
+  instancer.CreatePositionsAttr().Set(positions);
+  UsdGeomPrimvarsAPI(instancer)
+      .CreatePrimvar(UsdGeomTokens->primvarsDisplayColor,
+                     SdfValueTypeNames->Color3fArray, UsdGeomTokens->vertex)
+      .Set(colors);
+
+  TestGeoOp serialGeo;
+  WorkSetConcurrencyLimit(1);
+  addUsdPrim<UsdGeomPointInstancer>(*serialGeo.geometryList(), instancer,
+                                    UsdTimeCode::Default());
+  WorkSetMaximumConcurrencyLimit();
+  TestGeoOp parallelGeo;
+  addUsdPrim<UsdGeomPointInstancer>(*parallelGeo.geometryList(), instancer,
+                                    UsdTimeCode::Default());
+
+  const GeometryList& serial = *serialGeo.geometryList();
+  const GeometryList& parallel = *parallelGeo.geometryList();
+  REQUIRE(serial.size() == static_cast<int>(nInstances));
+  REQUIRE(parallel.size() == serial.size());
+  for(int obj = 0; obj < serial.size(); ++obj) {
+    const GeoInfo& expected = serial.object(obj);
+    const GeoInfo& info = parallel.object(obj);
+    const Attribute* transform =
+        info.get_group_attribute(Group_Object, kTransformAttrName);
+    REQUIRE(transform);
+    CHECK(transform->matrix4(0).translation() ==
+          Vector3(static_cast<float>(obj), 0, 0));
+    CHECK(transform->matrix4(0) ==
+          expected.get_group_attribute(Group_Object, kTransformAttrName)
+              ->matrix4(0));
+    const Attribute* Cf =
+        info.get_group_attribute(Group_Points, kColorAttrName);
+    REQUIRE(Cf);
+    CHECK(Cf->vector4(0) ==
+          expected.get_group_attribute(Group_Points, kColorAttrName)
+              ->vector4(0));
+    CHECK(Cf->vector4(0).x == Approx(static_cast<float>(obj) / nInstances));
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Nested instancers")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomPointInstancer inner =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/inner"));
+  inner.CreatePrototypesRel().AddTarget(cube.GetPath());
+  inner.CreateProtoIndicesAttr().Set(VtIntArray{0, 0});
+  inner.CreatePositionsAttr().Set(VtVec3fArray{{0, 1, 0}, {0, 2, 0}});
+  UsdGeomPrimvarsAPI(inner)
+      .CreatePrimvar(UsdGeomTokens->primvarsDisplayColor,
+                     SdfValueTypeNames->Color3fArray, UsdGeomTokens->vertex)
+      .Set(VtVec3fArray{{1, 0, 0}, {0, 1, 0}});
+  UsdGeomPointInstancer outer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/outer"));
+  outer.CreatePrototypesRel().AddTarget(inner.GetPath());
+  outer.CreateProtoIndicesAttr().Set(VtIntArray{0, 0});
+  outer.CreatePositionsAttr().Set(VtVec3fArray{{0, 0, 0}, {10, 0, 0}});
+
+  SECTION("Prototypes are resolved once")
+  {
+    ConversionCache cache;
+    const auto prototypes = cache.instancerPrototypes(outer);
+    CHECK(cache.instancerPrototypes(outer) == prototypes);
+    REQUIRE(prototypes->prims.size() == 1);
+    REQUIRE(prototypes->prims[0].size() == 1);
+    CHECK(prototypes->prims[0][0].GetPath() == inner.GetPath());
+  }
+
+  TestGeoOp geo;
+  addUsdPrim<UsdGeomPointInstancer>(*geo.geometryList(), outer,
+                                    UsdTimeCode::Default());
+  // Every inner instance of every outer instance
+  REQUIRE(geo.geometryList()->size() == 4);
+  const Attribute* transform =
+      geo.geometryList()->object(3).get_group_attribute(Group_Object,
+                                                        kTransformAttrName);
+  REQUIRE(transform);
+  CHECK(transform->matrix4(0).translation() == Vector3(10.0f, 2.0f, 0.0f));
+
+  // The leaves keep the colors of the inner instances they were added for
+  for(int obj = 0; obj < 4; ++obj) {
+    const Attribute* Cf = geo.geometryList()->object(obj).get_group_attribute(
+        Group_Points, kColorAttrName);
+    REQUIRE(Cf);
+    CHECK(Cf->vector4(0) ==
+          (obj % 2 == 0 ? Vector4(1, 0, 0, 1) : Vector4(0, 1, 0, 1)));
+  }
+}
+
+TEST_CASE("Instance transform samples")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0});
+  UsdAttribute positions = instancer.CreatePositionsAttr();
+  positions.Set(VtVec3fArray{{0, 0, 0}}, UsdTimeCode(1));
+  positions.Set(VtVec3fArray{{4, 0, 0}}, UsdTimeCode(2));
+
+  const std::vector<double> times = ShutterTimes(1.1, 3, 0.5);
+  REQUIRE(times == std::vector<double>{0.75, 1.0, 1.25});
+
+  ConversionCache cache;
+  const auto samples = cache.instanceTransforms(instancer, times);
+  REQUIRE(samples);
+  CHECK(cache.instanceTransforms(instancer, times) == samples);
+  REQUIRE(samples->transforms.size() == 3);
+  CHECK_FALSE(samples->find(1.1));
+  const VtMatrix4dArray* shutterClose = samples->find(1.25);
+  REQUIRE(shutterClose);
+  REQUIRE(shutterClose->size() == 1);
+  CHECK((*shutterClose)[0].ExtractTranslation()[0] == Approx(1.0));
+}
+
+TEST_CASE("Animated parts of a stage")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0});
+  UsdAttribute positions = instancer.CreatePositionsAttr();
+  positions.Set(VtVec3fArray{{0, 0, 0}}, UsdTimeCode(1));
+  positions.Set(VtVec3fArray{{4, 0, 0}}, UsdTimeCode(2));
+
+  // Only the instance transforms animate
+  const StageAnimation animation = ComputeStageAnimation(stage);
+  CHECK_FALSE(animation.topology);
+  CHECK_FALSE(animation.points);
+  CHECK(animation.instances);
+
+  const std::vector<UsdAttribute> attributes = cube.GetPrim().GetAttributes();
+  CHECK_FALSE(PrototypeAnimated(cube.GetPrim(), attributes));
+  UsdAttribute size = cube.CreateSizeAttr();
+  size.Set(1.0, UsdTimeCode(1));
+  size.Set(2.0, UsdTimeCode(2));
+  CHECK(PrototypeAnimated(cube.GetPrim(), attributes));
+
+  // The cube's points are built from its size
+  const StageAnimation resized = ComputeStageAnimation(stage);
+  CHECK_FALSE(resized.topology);
+  CHECK(resized.points);
+}
+
+TEST_CASE("Animated instance orientations and scales")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0});
+  instancer.CreatePositionsAttr().Set(VtVec3fArray{{0, 0, 0}});
+  CHECK_FALSE(ComputeStageAnimation(stage).instances);
+
+  SECTION("Orientations")
+  {
+    UsdAttribute orientations = instancer.CreateOrientationsAttr();
+    orientations.Set(VtQuathArray{GfQuath(1)}, UsdTimeCode(1));
+    orientations.Set(VtQuathArray{GfQuath(0, 1, 0, 0)}, UsdTimeCode(2));
+    CHECK(ComputeStageAnimation(stage).instances);
+  }
+
+  SECTION("Scales")
+  {
+    UsdAttribute scales = instancer.CreateScalesAttr();
+    scales.Set(VtVec3fArray{{1, 1, 1}}, UsdTimeCode(1));
+    scales.Set(VtVec3fArray{{2, 2, 2}}, UsdTimeCode(2));
+    CHECK(ComputeStageAnimation(stage).instances);
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Instancer proxies")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0, 0, 0});
+  const VtVec3fArray positions{{1, 0, 0}, {2, 0, 0}, {3, 0, 0}};
+  instancer.CreatePositionsAttr().Set(positions);
+
+  ConversionOptions options;
+  options.instanceThreshold = 2;
+  TestGeoOp geo;
+
+  SECTION("Points")
+  {
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    // The cube, then one particle per instance
+    REQUIRE(geo.geometryList()->size() == 2);
+    const GeoInfo& info = geo.geometryList()->object(1);
+    CHECK_THAT(positions,
+               ArraysOfVectorsEqual<decltype(positions)>(*info.point_list(), 3));
+    const Attribute* indices =
+        info.get_group_attribute(Group_Points, kProtoIndexAttrName);
+    REQUIRE(indices);
+    CHECK(*indices->int_list == std::vector<int>{0, 0, 0});
+    CHECK(info.get_group_attribute(Group_Points, kOrientAttrName));
+    CHECK(info.get_group_attribute(Group_Points, kScaleAttrName));
+    const Attribute* transform =
+        info.get_group_attribute(Group_Object, kTransformAttrName);
+    REQUIRE(transform);
+    CHECK(transform->matrix4(0) == Matrix4::identity());
+  }
+
+  SECTION("Boxes")
+  {
+    options.instanceProxy = InstanceProxy::Boxes;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    REQUIRE(geo.geometryList()->size() == 2);
+    const GeoInfo& info = geo.geometryList()->object(1);
+    CHECK(info.point_list()->size() == 3 * 8);
+  }
+
+  SECTION("Invisible instances")
+  {
+    instancer.CreateInvisibleIdsAttr().Set(VtInt64Array{1});
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    REQUIRE(geo.geometryList()->size() == 2);
+    // The visible instances keep their own transforms
+    const VtVec3fArray visible{{1, 0, 0}, {3, 0, 0}};
+    CHECK_THAT(visible, ArraysOfVectorsEqual<decltype(visible)>(
+                            *geo.geometryList()->object(1).point_list(), 3));
+  }
+
+  SECTION("Expanded under the threshold")
+  {
+    options.instanceThreshold = 3;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    CHECK(geo.geometryList()->size() == 4);
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Crop box")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomCube::Define(stage, SdfPath("/far")).AddTranslateOp().Set(
+      GfVec3d(20, 0, 0));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0, 0, 0});
+  instancer.CreatePositionsAttr().Set(
+      VtVec3fArray{{20, 0, 0}, {1, 0, 0}, {40, 0, 0}});
+
+  ConversionOptions options;
+  options.crop = true;
+  options.cropBox = GfRange3d(GfVec3d(-2), GfVec3d(2));
+  TestGeoOp geo;
+  convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                     nullptr, options);
+  // The cube, then the only instance overlapping the box
+  REQUIRE(geo.geometryList()->size() == 2);
+  const Attribute* transform =
+      geo.geometryList()->object(1).get_group_attribute(Group_Object,
+                                                        kTransformAttrName);
+  REQUIRE(transform);
+  CHECK(transform->matrix4(0).translation() == Vector3(1.0f, 0.0f, 0.0f));
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Crop box with invisible instances")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0, 0, 0});
+  instancer.CreatePositionsAttr().Set(
+      VtVec3fArray{{20, 0, 0}, {1, 0, 0}, {40, 0, 0}});
+  // Hiding the first instance mustn't shift the transforms of the others
+  instancer.CreateInvisibleIdsAttr().Set(VtInt64Array{0});
+
+  ConversionOptions options;
+  options.crop = true;
+  options.cropBox = GfRange3d(GfVec3d(-2), GfVec3d(2));
+  TestGeoOp geo;
+  convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                     nullptr, options);
+  // The cube, then the visible instance overlapping the box
+  REQUIRE(geo.geometryList()->size() == 2);
+  const Attribute* transform =
+      geo.geometryList()->object(1).get_group_attribute(Group_Object,
+                                                        kTransformAttrName);
+  REQUIRE(transform);
+  CHECK(transform->matrix4(0).translation() == Vector3(1.0f, 0.0f, 0.0f));
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Crop box with a transformed prototype")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomCube cube = UsdGeomCube::Define(stage, SdfPath("/cube"));
+  cube.AddTranslateOp().Set(GfVec3d(10, 0, 0));
+  cube.AddScaleOp().Set(GfVec3f(2, 2, 2));
+  UsdGeomPointInstancer instancer =
+      UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+  instancer.CreatePrototypesRel().AddTarget(cube.GetPath());
+  instancer.CreateProtoIndicesAttr().Set(VtIntArray{0, 0});
+  // The first instance lands on the origin, the second well outside the box
+  instancer.CreatePositionsAttr().Set(
+      VtVec3fArray{{-10, 0, 0}, {20, 0, 0}});
+
+  ConversionOptions options;
+  options.crop = true;
+  options.cropBox = GfRange3d(GfVec3d(-2), GfVec3d(2));
+  TestGeoOp geo;
+
+  SECTION("Expanded instances")
+  {
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    // The cube is outside the box, so only the first instance is added
+    REQUIRE(geo.geometryList()->size() == 1);
+    const Attribute* transform =
+        geo.geometryList()->object(0).get_group_attribute(Group_Object,
+                                                          kTransformAttrName);
+    REQUIRE(transform);
+    CHECK(transform->matrix4(0).translation() == Vector3(0.0f, 0.0f, 0.0f));
+  }
+
+  SECTION("Box proxy")
+  {
+    options.instanceThreshold = 1;
+    options.instanceProxy = InstanceProxy::Boxes;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    REQUIRE(geo.geometryList()->size() == 1);
+    const PointList& points = *geo.geometryList()->object(0).point_list();
+    REQUIRE(points.size() == 8);
+    // The cube of size 2, scaled by 2 around the origin
+    for(const Vector3& p : points) {
+      CHECK(std::abs(p.x) == Approx(2.0f));
+      CHECK(std::abs(p.y) == Approx(2.0f));
+      CHECK(std::abs(p.z) == Approx(2.0f));
+    }
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Attribute filter")
+{
+  SECTION("Glob patterns")
+  {
+    CHECK(MatchGlob("*", ""));
+    CHECK(MatchGlob("display*", "displayColor"));
+    CHECK(MatchGlob("d?splay*r", "displayColor"));
+    CHECK(MatchGlob("*Color", "displayColor"));
+    CHECK_FALSE(MatchGlob("display", "displayColor"));
+    CHECK_FALSE(MatchGlob("*Opacity", "displayColor"));
+  }
+
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomMesh mesh = UsdGeomMesh::Define(stage, SdfPath("/triangle"));
+  mesh.CreatePointsAttr().Set(VtVec3fArray{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}});
+  mesh.CreateFaceVertexCountsAttr().Set(VtIntArray{3});
+  mesh.CreateFaceVertexIndicesAttr().Set(VtIntArray{0, 1, 2});
+  mesh.CreateDisplayColorPrimvar(UsdGeomTokens->constant)
+      .Set(VtVec3fArray{{1, 0, 0}});
+  mesh.CreateVelocitiesAttr().Set(
+      VtVec3fArray{{0, 1, 0}, {0, 1, 0}, {0, 1, 0}});
+
+  SECTION("Excluded primvars are not read")
+  {
+    ConversionOptions options;
+    options.attributeExclude = "display*";
+    TestGeoOp geo;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    REQUIRE(geo.geometryList()->size() == 1);
+    const GeoInfo& info = geo.geometryList()->object(0);
+    CHECK(info.points()->size() == 3);
+    CHECK(info.get_group_attribute(Group_Points, kVelocityAttrName));
+    CHECK_FALSE(info.get_group_attribute(Group_Object, kColorAttrName));
+  }
+
+  SECTION("Only included attributes are read, with the points")
+  {
+    ConversionOptions options;
+    options.attributeInclude = "primvars:displayColor";
+    TestGeoOp geo;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    REQUIRE(geo.geometryList()->size() == 1);
+    const GeoInfo& info = geo.geometryList()->object(0);
+    CHECK(info.points()->size() == 3);
+    CHECK(info.primitives() == 1);
+    CHECK_FALSE(info.get_group_attribute(Group_Points, kVelocityAttrName));
+    CHECK(info.get_group_attribute(Group_Object, kColorAttrName));
+  }
+
+  SECTION("Instancer attributes are filtered too")
+  {
+    UsdGeomPointInstancer instancer =
+        UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+    instancer.CreatePrototypesRel().AddTarget(mesh.GetPath());
+    instancer.CreateProtoIndicesAttr().Set(VtIntArray{0, 0});
+    instancer.CreatePositionsAttr().Set(VtVec3fArray{{0, 0, 0}, {2, 0, 0}});
+    UsdGeomPrimvarsAPI(instancer)
+        .CreatePrimvar(UsdGeomTokens->primvarsDisplayColor,
+                       SdfValueTypeNames->Color3fArray, UsdGeomTokens->vertex)
+        .Set(VtVec3fArray{{0, 0, 1}, {0, 1, 0}});
+
+    ConversionOptions options;
+    options.attributeExclude = "display*";
+    TestGeoOp geo;
+    convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default(),
+                       nullptr, options);
+    // The triangle, then one object per instance
+    REQUIRE(geo.geometryList()->size() == 3);
+    for(int obj = 1; obj < 3; ++obj) {
+      const GeoInfo& info = geo.geometryList()->object(obj);
+      CHECK(info.points()->size() == 3);
+      CHECK_FALSE(info.get_group_attribute(Group_Points, kColorAttrName));
+      CHECK_FALSE(info.get_group_attribute(Group_Object, kColorAttrName));
+      // The prototype's velocities pass the filter
+      CHECK(info.get_group_attribute(Group_Points, kVelocityAttrName));
+    }
+  }
+}
+
+TEST_CASE_METHOD(MemoryAllocator, "Inherited primvars")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomXform asset = UsdGeomXform::Define(stage, SdfPath("/asset"));
+  UsdGeomPrimvarsAPI(asset)
+      .CreatePrimvar(UsdGeomTokens->primvarsDisplayColor,
+                     SdfValueTypeNames->Color3fArray, UsdGeomTokens->constant)
+      .Set(VtVec3fArray{{1, 0, 0}});
+  for(const char* path : {"/asset/inherits", "/asset/overrides"}) {
+    UsdGeomMesh mesh = UsdGeomMesh::Define(stage, SdfPath(path));
+    mesh.CreatePointsAttr().Set(
+        VtVec3fArray{{0, 0, 0}, {1, 0, 0}, {1, 1, 0}});
+    mesh.CreateFaceVertexCountsAttr().Set(VtIntArray{3});
+    mesh.CreateFaceVertexIndicesAttr().Set(VtIntArray{0, 1, 2});
+  }
+  UsdGeomMesh(stage->GetPrimAtPath(SdfPath("/asset/overrides")))
+      .CreateDisplayColorPrimvar(UsdGeomTokens->constant)
+      .Set(VtVec3fArray{{0, 1, 0}});
+
+  TestGeoOp geo;
+  convertUsdGeometry(*geo.geometryList(), stage, UsdTimeCode::Default());
+  REQUIRE(geo.geometryList()->size() == 2);
+  const Attribute* inherited =
+      geo.geometryList()->object(0).get_group_attribute(Group_Object,
+                                                        kColorAttrName);
+  REQUIRE(inherited);
+  CHECK(inherited->vector4(0) == Vector4(1, 0, 0, 1));
+  const Attribute* overridden =
+      geo.geometryList()->object(1).get_group_attribute(Group_Object,
+                                                        kColorAttrName);
+  REQUIRE(overridden);
+  CHECK(overridden->vector4(0) == Vector4(0, 1, 0, 1));
+}
+
 TEST_CASE_METHOD(MemoryAllocator, "Add transforms")
 {
   UsdStageRefPtr stage = UsdStage::CreateInMemory();
@@ -315,6 +1140,47 @@ TEST_CASE_METHOD(MemoryAllocator, "Add transforms")
   }
 }
 
+TEST_CASE("World transforms of nested prims")
+{
+  UsdStageRefPtr stage = UsdStage::CreateInMemory();
+  UsdGeomXform parent = UsdGeomXform::Define(stage, SdfPath("/parent"));
+  parent.AddTranslateOp().Set(GfVec3d(1, 2, 3));
+  UsdGeomXform child = UsdGeomXform::Define(stage, SdfPath("/parent/child"));
+  child.AddTranslateOp().Set(GfVec3d(10, 20, 30));
+  UsdGeomXform reset = UsdGeomXform::Define(stage, SdfPath("/parent/reset"));
+  reset.SetResetXformStack(true);
+  reset.AddTranslateOp().Set(GfVec3d(5, 5, 5));
+
+  SECTION("Y up")
+  {
+    const PrimHierarchy hierarchy(stage);
+    REQUIRE(hierarchy.size() == 3);
+    REQUIRE(hierarchy.levels().size() == 2);
+
+    const WorldTransforms transforms(hierarchy, UsdGeomTokens->y,
+                                     UsdTimeCode::Default());
+    GfMatrix4d world;
+    REQUIRE(transforms.get(SdfPath("/parent/child"), &world));
+    CHECK(world.ExtractTranslation() == GfVec3d(11, 22, 33));
+    REQUIRE(transforms.get(SdfPath("/parent/reset"), &world));
+    CHECK(world.ExtractTranslation() == GfVec3d(5, 5, 5));
+    CHECK_FALSE(transforms.get(SdfPath("/missing"), &world));
+  }
+
+  SECTION("Z up rotation is applied once")
+  {
+    const PrimHierarchy hierarchy(stage);
+    const WorldTransforms transforms(hierarchy, UsdGeomTokens->z,
+                                     UsdTimeCode::Default());
+    GfMatrix4d world;
+    REQUIRE(transforms.get(SdfPath("/parent/child"), &world));
+    GfMatrix4d expected(1.0);
+    expected.SetTranslate(GfVec3d(11, 22, 33));
+    ApplyUpAxisRotation(expected, UsdGeomTokens->z);
+    CHECK(world == expected);
+  }
+}
+
 TEST_CASE("getPrimitiveData returns correct data")
 {
   UsdStageRefPtr stage = UsdStage::CreateInMemory();